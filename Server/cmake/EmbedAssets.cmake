@@ -0,0 +1,111 @@
+# 把 static 目录编译进二进制：每个文件生成一个 constexpr 字节数组，
+# 同时在构建期算好 SHA1 (用作 ETag)、MIME 类型和 gzip 版本
+#
+# 用法: cmake -DSTATIC_DIR=<目录> -DOUTPUT=<生成的头文件> -P EmbedAssets.cmake
+# (需要在 STATIC_DIR 下执行；gzip 需要 CMake >= 3.19，更老的版本留给启动时压缩)
+
+file(GLOB_RECURSE files RELATIVE "${STATIC_DIR}" "${STATIC_DIR}/*")
+list(FILTER files EXCLUDE REGEX "(^|/)\\.") # 跳过 .DS_Store 之类的隐藏文件
+list(SORT files)
+
+string(TIMESTAMP build_time "%a, %d %b %Y %H:%M:%S GMT" UTC)
+get_filename_component(work_dir "${OUTPUT}" DIRECTORY)
+set(can_gzip FALSE)
+if(CMAKE_VERSION VERSION_GREATER_EQUAL 3.19)
+    set(can_gzip TRUE)
+endif()
+
+# 读文件转成 C 数组的初始化列表，末尾多补一个 0，避免空文件生成零长度数组
+function(to_bytes path out_var)
+    file(READ "${path}" hex HEX)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${hex}")
+    set(${out_var} "${bytes}0x00" PARENT_SCOPE)
+endfunction()
+
+set(body "")
+set(table "")
+set(index 0)
+foreach(name IN LISTS files)
+    set(path "${STATIC_DIR}/${name}")
+    to_bytes("${path}" bytes)
+    file(SIZE "${path}" size)
+    file(SHA1 "${path}" sha1)
+
+    get_filename_component(ext "${name}" LAST_EXT)
+    string(TOLOWER "${ext}" ext)
+    if(ext STREQUAL ".html" OR ext STREQUAL ".htm")
+        set(mime "text/html; charset=utf-8")
+    elseif(ext STREQUAL ".css")
+        set(mime "text/css")
+    elseif(ext STREQUAL ".js")
+        set(mime "application/javascript")
+    elseif(ext STREQUAL ".json")
+        set(mime "application/json")
+    elseif(ext STREQUAL ".png")
+        set(mime "image/png")
+    elseif(ext STREQUAL ".jpg" OR ext STREQUAL ".jpeg")
+        set(mime "image/jpeg")
+    elseif(ext STREQUAL ".gif")
+        set(mime "image/gif")
+    elseif(ext STREQUAL ".svg")
+        set(mime "image/svg+xml")
+    elseif(ext STREQUAL ".ico")
+        set(mime "image/x-icon")
+    elseif(ext STREQUAL ".mp3")
+        set(mime "audio/mpeg")
+    elseif(ext STREQUAL ".ogg")
+        set(mime "audio/ogg")
+    elseif(ext STREQUAL ".wav")
+        set(mime "audio/wav")
+    else()
+        set(mime "text/plain")
+    endif()
+
+    string(APPEND body "inline constexpr unsigned char EMBEDDED_ASSET_${index}[] = {${bytes}};\n")
+
+    # 文本类资源预压缩，只保留确实变小了的版本 (图片/音频本身已经压缩过)
+    set(gz_ref "nullptr")
+    set(gz_size 0)
+    if(can_gzip AND (mime MATCHES "^text/" OR mime MATCHES "javascript|json|svg"))
+        set(gz "${work_dir}/embed_${index}.gz")
+        file(ARCHIVE_CREATE OUTPUT "${gz}" PATHS "${name}" FORMAT raw COMPRESSION GZip COMPRESSION_LEVEL 9)
+        file(SIZE "${gz}" gz_size)
+        if(gz_size LESS size)
+            to_bytes("${gz}" gz_bytes)
+            string(APPEND body "inline constexpr unsigned char EMBEDDED_ASSET_${index}_GZ[] = {${gz_bytes}};\n")
+            set(gz_ref "EMBEDDED_ASSET_${index}_GZ")
+        else()
+            set(gz_size 0)
+        endif()
+        file(REMOVE "${gz}")
+    endif()
+
+    string(APPEND table "    {\"${name}\", EMBEDDED_ASSET_${index}, ${size}, ${gz_ref}, ${gz_size}, \"\\\"${sha1}\\\"\", \"${mime}\"},\n")
+    math(EXPR index "${index} + 1")
+endforeach()
+
+set(content "// 由 cmake/EmbedAssets.cmake 生成，请勿手动修改
+#pragma once
+#include <cstddef>
+
+struct EmbeddedAsset {
+    const char* name; // 相对 static 目录的路径
+    const unsigned char* data; // 文件内容
+    std::size_t size; // 文件大小（字节）
+    const unsigned char* gzip_data; // gzip 版本，构建时没有生成则为 nullptr
+    std::size_t gzip_size;
+    const char* etag; // 构建期计算的 SHA1，带引号
+    const char* mime; // Content-Type
+};
+
+inline constexpr const char* EMBEDDED_BUILD_TIME = \"${build_time}\";
+
+${body}
+inline constexpr EmbeddedAsset EMBEDDED_ASSETS[] = {
+${table}    {nullptr, nullptr, 0, nullptr, 0, nullptr, nullptr}
+};
+
+inline constexpr std::size_t EMBEDDED_ASSET_COUNT = ${index};
+")
+
+file(WRITE "${OUTPUT}" "${content}")
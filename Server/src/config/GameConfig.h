@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <cstddef>
 
 struct LevelConfig {
     int level_id; // 关卡ID
@@ -13,22 +14,82 @@ struct LevelConfig {
     std::string desc; // 关卡描述
 };
 
+// 道具售价
+struct ItemPrice {
+    const char* item; // 道具类型
+    int cost; // 金币
+};
+
+// 令牌桶限额
+struct RateLimit {
+    const char* route; // 接口路径，不区分接口时为空
+    double rate; // 每秒补充的令牌数
+    int burst; // 桶容量（允许的瞬时突发请求数）
+};
+
 class GameConfig {
 public:
     inline static const int COIN_REWARD_LEVEL_PASS = 100;  // 通关关卡的金币奖励
     inline static const int COIN_DIVISOR_ENDLESS = 100; // 无尽模式的金币除数
 
-    inline static const int ITEM_COST_BOMB = 30; // 炸弹道具成本
-    inline static const int ITEM_COST_RESET = 30; // 重置道具成本
-    inline static const int ITEM_COST_FREEZE = 30; // 冻结道具成本
+    // 商店价目表
+    inline static const std::vector<ItemPrice> ITEM_PRICES = {
+        {"bomb", 30},   // 炸弹
+        {"reset", 30},  // 重置
+        {"freeze", 30}, // 冻结
+    };
 
     inline static const int AI_DELAY_EASY = 5000;   // 简单AI延迟（毫秒）
     inline static const int AI_DELAY_NORMAL = 3000; // 普通AI延迟（毫秒）
     inline static const int AI_DELAY_HARD = 1000;    // 困难AI延迟（毫秒）
 
     inline static const int FREEZE_DURATION_MS = 3000; // 冻结持续时间（毫秒）
+
+    inline static const int PUSH_TICK_MS = 1000; // WebSocket 推送节拍（毫秒），驱动倒计时与 AI
+    inline static const size_t BATCH_MAX_COMMANDS = 32; // 单次批量请求的最大指令数
+    inline static const size_t SEQ_REPLAY_WINDOW = 8; // 每局保留最近多少个移动序号的结果，供重试时重放
+
+    // --- 限流 (令牌桶)，超限返回 429 ---
+    inline static const RateLimit RATE_PER_IP = {nullptr, 50, 100}; // 每个 IP 的总限额（同一出口 IP 后面可能有多个玩家，放宽一些）
+    inline static const RateLimit RATE_PER_UID = {nullptr, 20, 40}; // 每个登录用户的总限额
+    // 单个接口的限额，按 uid 计（未登录时、以及 /api/auth/* 按 IP 计）
+    inline static const std::vector<RateLimit> RATE_PER_ROUTE = {
+        {"/api/game/move", 10, 20},
+        {"/api/game/batch", 4, 8},
+        {"/api/game/use_item", 4, 8},
+        {"/api/pvp/status", 10, 20},
+        {"/api/pvp/match", 1, 5},
+        {"/api/shop/buy", 2, 5},
+        {"/api/auth/login", 0.2, 5},    // 每 5 秒 1 次，防止撞库
+        {"/api/auth/register", 0.1, 3},
+    };
     // ------------------------------------
 
+    // --- 数据库 (SQLite, WAL 模式) ---
+    inline static const int DB_BUSY_TIMEOUT_MS = 2000; // 遇到锁时驱动内部等待的最长时间
+    inline static const int DB_BUSY_RETRIES = 3; // 等待后仍然 SQLITE_BUSY 时的额外重试次数
+    inline static const int DB_CACHE_SIZE_KB = 8192; // 每个连接的页缓存
+    inline static const long long DB_MMAP_SIZE = 256LL * 1024 * 1024; // 内存映射读的上限
+    inline static const int DB_CHECKPOINT_INTERVAL_MS = 5000; // 后台检查点间隔
+    inline static const int DB_WAL_TRUNCATE_PAGES = 10000; // WAL 超过这么多页时做一次截断检查点（约 40MB）
+    inline static const int DB_WRITE_BEHIND_MS = 200; // 分数/金币写缓冲的最长滞留时间（进程崩溃时最多丢这么久的改动）
+    inline static const size_t DB_WRITE_BEHIND_BATCH = 256; // 攒够这么多个用户就立即提交
+    inline static const size_t USER_CACHE_CAPACITY = 16384; // 内存里最多缓存的用户资料条数
+    // ------------------------------------
+
+    inline static const size_t RANK_TOP_SIZE = 10; // 排行榜默认显示的名次数
+    inline static const int RANK_PAGE_MAX = 100; // 分页查询一页最多的条数
+    inline static const int RANK_TZ_OFFSET_SEC = 8 * 3600; // 日榜/周榜按这个时区切换（北京时间 0 点，周榜从周一开始）
+    inline static const int RANK_SAVE_INTERVAL_MS = 60000; // 当前日榜/周榜定时存快照的间隔（进程崩溃时最多丢这么久的窗口数据）
+
+    // 道具售价，不在价目表上的返回 -1
+    static int getItemCost(const std::string& itemType) {
+        for (const ItemPrice& p : ITEM_PRICES) {
+            if (itemType == p.item) return p.cost;
+        }
+        return -1;
+    }
+
     static LevelConfig getLevelConfig(int level) {
         switch (level) {
             case 1: return {1, 1000, -1, 0, 0, 0, 0, "LV1: 热身运动"};
@@ -0,0 +1,143 @@
+#include "ServerConfig.h"
+#include "json.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <thread>
+#include <algorithm>
+
+namespace {
+
+// 数值参数的取值范围，配置文件和环境变量共用
+struct Bounds {
+    long long min;
+    long long max;
+};
+const Bounds PORT_RANGE = {0, 65535};
+const Bounds THREADS_RANGE = {0, 1024};
+const Bounds MAX_BODY_RANGE = {1, 1LL << 30};
+const Bounds KEEPALIVE_RANGE = {1, 255};
+const Bounds MATCH_DURATION_RANGE = {1, 24 * 3600};
+const Bounds SHUTDOWN_GRACE_RANGE = {0, 3600};
+
+// 读取数值型环境变量，格式不对时给出警告并保持原值
+template <typename T>
+void envNumber(const char* name, T& out, Bounds range) {
+    const char* v = std::getenv(name);
+    if (!v || !*v) return;
+    char* end = nullptr;
+    long long n = std::strtoll(v, &end, 10);
+    if (*end != '\0' || n < range.min || n > range.max) {
+        std::cerr << "Warning: ignoring invalid " << name << "=" << v << std::endl;
+        return;
+    }
+    out = static_cast<T>(n);
+}
+
+// 读取配置文件里的数值：按 long long 取出再检查范围，避免转成目标类型时被截断或回绕。
+// 不是整数或超出范围时返回 false（启动失败）
+template <typename T>
+bool fileNumber(const nlohmann::json& cfg, const char* key, T& out, Bounds range) {
+    auto it = cfg.find(key);
+    if (it == cfg.end()) return true;
+    if (!it->is_number_integer()) {
+        std::cerr << "Error: " << key << " must be an integer" << std::endl;
+        return false;
+    }
+    // 非负整数在 json 里都是 number_unsigned，可能超出 long long，先按无符号比较上下限
+    bool inRange;
+    if (it->is_number_unsigned()) {
+        unsigned long long n = it->get<unsigned long long>();
+        inRange = (range.min <= 0 || n >= static_cast<unsigned long long>(range.min)) &&
+                  n <= static_cast<unsigned long long>(range.max);
+    } else {
+        long long n = it->get<long long>();
+        inRange = n >= range.min && n <= range.max;
+    }
+    if (!inRange) {
+        std::cerr << "Error: " << key << " must be between " << range.min << " and " << range.max << std::endl;
+        return false;
+    }
+    out = static_cast<T>(it->get<long long>());
+    return true;
+}
+
+void envString(const char* name, std::string& out) {
+    const char* v = std::getenv(name);
+    if (v && *v) out = v;
+}
+
+} // namespace
+
+// 单例实现
+ServerConfig& ServerConfig::getInstance() {
+    static ServerConfig instance;
+    return instance;
+}
+
+bool ServerConfig::load(const std::string& path) {
+    std::ifstream in(path);
+    if (in) {
+        // 允许在配置文件里写注释
+        auto cfg = nlohmann::json::parse(in, nullptr, false, true);
+        if (cfg.is_discarded() || !cfg.is_object()) {
+            std::cerr << "Error: invalid config file " << path << std::endl;
+            return false;
+        }
+        try {
+            bindaddr = cfg.value("bindaddr", bindaddr);
+            unix_socket = cfg.value("unix_socket", unix_socket);
+            db_path = cfg.value("db_path", db_path);
+            static_dir = cfg.value("static_dir", static_dir);
+        } catch (const nlohmann::json::exception& e) {
+            std::cerr << "Error: invalid value in config file " << path << ": " << e.what() << std::endl;
+            return false;
+        }
+        if (!fileNumber(cfg, "port", port, PORT_RANGE) ||
+            !fileNumber(cfg, "threads", threads, THREADS_RANGE) ||
+            !fileNumber(cfg, "max_body_bytes", max_body_bytes, MAX_BODY_RANGE) ||
+            !fileNumber(cfg, "keep_alive_sec", keep_alive_sec, KEEPALIVE_RANGE) ||
+            !fileNumber(cfg, "match_duration_sec", match_duration_sec, MATCH_DURATION_RANGE) ||
+            !fileNumber(cfg, "shutdown_grace_sec", shutdown_grace_sec, SHUTDOWN_GRACE_RANGE)) {
+            std::cerr << "Error: invalid value in config file " << path << std::endl;
+            return false;
+        }
+        source = path;
+    }
+
+    applyEnv();
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    if (port == 0 && unix_socket.empty()) {
+        std::cerr << "Error: nothing to listen on (port is 0 and unix_socket is empty)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void ServerConfig::applyEnv() {
+    envNumber("GAME_PORT", port, PORT_RANGE);
+    envString("GAME_BINDADDR", bindaddr);
+    envString("GAME_UNIX_SOCKET", unix_socket);
+    envNumber("GAME_THREADS", threads, THREADS_RANGE);
+    envString("GAME_DB_PATH", db_path);
+    envString("GAME_STATIC_DIR", static_dir);
+    envNumber("GAME_MAX_BODY_BYTES", max_body_bytes, MAX_BODY_RANGE);
+    envNumber("GAME_KEEPALIVE_SEC", keep_alive_sec, KEEPALIVE_RANGE);
+    envNumber("GAME_MATCH_DURATION_SEC", match_duration_sec, MATCH_DURATION_RANGE);
+    envNumber("GAME_SHUTDOWN_GRACE_SEC", shutdown_grace_sec, SHUTDOWN_GRACE_RANGE);
+}
+
+void ServerConfig::print() const {
+    std::cout << "[Info] Config (" << source << ", env overrides applied):" << std::endl
+              << "[Info]   listen         " << (port ? bindaddr + ":" + std::to_string(port) : "-") << std::endl
+              << "[Info]   unix_socket    " << (unix_socket.empty() ? "-" : unix_socket) << std::endl
+              << "[Info]   threads        " << threads << std::endl
+              << "[Info]   db_path        " << db_path << std::endl
+              << "[Info]   static_dir     " << static_dir << std::endl
+              << "[Info]   max_body_bytes " << max_body_bytes << std::endl
+              << "[Info]   keep_alive_sec " << keep_alive_sec << std::endl
+              << "[Info]   match_duration " << match_duration_sec << "s" << std::endl
+              << "[Info]   shutdown_grace " << shutdown_grace_sec << "s" << std::endl;
+}
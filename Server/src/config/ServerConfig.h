@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// 服务运行参数：启动时先读配置文件（JSON，不存在则全部用默认值），再用环境变量覆盖。
+// 只在启动阶段写入，之后各线程只读
+class ServerConfig {
+public:
+    // 单例获取
+    static ServerConfig& getInstance();
+
+    // 禁止拷贝
+    ServerConfig(const ServerConfig&) = delete;
+    void operator=(const ServerConfig&) = delete;
+
+    // 读取配置，文件格式错误时返回 false
+    bool load(const std::string& path);
+    // 打印生效的配置
+    void print() const;
+
+    std::uint16_t port = 8000; // 监听端口，0 表示不监听 TCP (GAME_PORT)
+    std::string bindaddr = "0.0.0.0"; // 监听地址   (GAME_BINDADDR)
+    std::string unix_socket; // Unix 域套接字路径，给同机的反向代理用，空表示不监听 (GAME_UNIX_SOCKET)
+    unsigned threads = 0; // Crow 工作线程数，0 表示按 CPU 核数 (GAME_THREADS)
+    std::string db_path = "game.db"; // 数据库文件  (GAME_DB_PATH)
+    std::string static_dir = "static"; // 静态资源目录 (GAME_STATIC_DIR)
+    std::size_t max_body_bytes = 64 * 1024; // 请求体 / WebSocket 消息大小上限 (GAME_MAX_BODY_BYTES)
+    int keep_alive_sec = 5; // 空闲连接超时（秒，1-255） (GAME_KEEPALIVE_SEC)
+    int match_duration_sec = 60; // PVP/PVE 一局的时长（秒） (GAME_MATCH_DURATION_SEC)
+    int shutdown_grace_sec = 30; // 停机时等待进行中对局自然结束的最长时间（秒），超时强制结算 (GAME_SHUTDOWN_GRACE_SEC)
+
+    std::string source = "defaults"; // 配置来源，打印用
+
+private:
+    ServerConfig() = default; // 私有构造
+
+    void applyEnv();
+};
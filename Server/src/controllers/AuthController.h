@@ -1,10 +1,12 @@
 #pragma once
 #include "crow_all.h"
 #include "../utils/Response.h"
+#include "../utils/Request.h"
 #include <iostream>
 #include <string>
 #include <models/User.h>
 #include "../dao/UserDao.h"
+#include "../dao/UserCache.h"
 
 class AuthController {
 private:
@@ -19,13 +21,15 @@ public:
         //登录接口
         CROW_ROUTE(app, "/api/auth/login").methods(crow::HTTPMethod::POST)
         ([this](const crow::request& req) {
-            auto body = json::parse(req.body);
-            std::string account = body["account"];
-            std::string password = body["password"];
+            LoginRequest in;
+            if (auto err = decodeRequest(req.body, in)) return crow::response(400, Response::badRequest(err->field, err->msg));
 
             User user;
-            if (userDao.login(account, password, user)) {
-                json data;
+            if (userDao.login(in.account, in.password, user)) {
+                // 资产以缓存为准（包含写缓冲里还没落盘的奖励）
+                UserCache::getInstance().getUser(user.uid, user);
+
+                ArenaJson data;
                 data["token"] = "mock-token-" + std::to_string(user.uid);
                 data["uid"] = user.uid;
                 data["nickname"] = user.nickname;
@@ -39,12 +43,10 @@ public:
         //注册接口
         CROW_ROUTE(app, "/api/auth/register").methods(crow::HTTPMethod::POST)
         ([this](const crow::request& req) {
-            auto body = json::parse(req.body);
-            std::string account = body["account"];
-            std::string password = body["password"];
-            std::string nickname = body.value("nickname", "NewPlayer");
+            RegisterRequest in;
+            if (auto err = decodeRequest(req.body, in)) return crow::response(400, Response::badRequest(err->field, err->msg));
 
-            if (userDao.registerUser(account, password, nickname)) {
+            if (userDao.registerUser(in.account, in.password, in.nickname)) {
                 return crow::response(Response::success().dump());
             } else {
                 return crow::response(400, Response::error(400, "该账号已存在").dump());
@@ -54,12 +56,13 @@ public:
         //同步用户信息接口
         CROW_ROUTE(app, "/api/user/sync").methods(crow::HTTPMethod::POST)
         ([this](const crow::request& req) {
-            auto body = json::parse(req.body);
-            int uid = body.value("uid", 0);
+            UidRequest in;
+            if (auto err = decodeRequest(req.body, in)) return crow::response(400, Response::badRequest(err->field, err->msg));
+            int uid = in.uid;
 
             User user;
-            if (userDao.getUserById(uid, user)) {
-                json data;
+            if (UserCache::getInstance().getUser(uid, user)) {
+                ArenaJson data;
                 data["uid"] = uid;
                 data["nickname"] = user.nickname;
                 data["assets"] = user.toAssetsJson();
@@ -1,7 +1,13 @@
 #pragma once
 #include "crow_all.h"
 #include "../services/GameService.h"
+#include "../services/RankService.h"
 #include "../utils/Response.h"
+#include "../utils/Request.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 
 class GameController {
 public:
@@ -11,20 +17,19 @@ public:
         //开始游戏
         CROW_ROUTE(app, "/api/game/start").methods(crow::HTTPMethod::POST)
         ([](const crow::request& req) {
-            auto body = json::parse(req.body);
-            std::string mode = body.value("mode", "level");
-            int level = body.value("level", 1);
-            int uid = body.value("uid", 0);
-            
+            StartRequest in;
+            if (auto err = decodeRequest(req.body, in)) return crow::response(400, Response::badRequest(err->field, err->msg));
+            int level = in.level;
+
             //创建游戏对象，后续用uuid来定位游戏
-            GameSession* session = GameService::getInstance().createSession(uid, mode, level);
+            GameSession* session = GameService::getInstance().createSession(in.uid, in.mode, level);
 
-            json data;
+            ArenaJson data;
             data["game_uuid"] = session->uuid;
             data["map"] = session->map;
             data["ice_map"] = session->ice_map;
 
-            json bombList = json::array();
+            ArenaJson bombList = ArenaJson::array();
             for(auto const& [key, val] : session->bomb_map)
                 bombList.push_back({ {"r", key/8}, {"c", key%8}, {"timer", val} });
             data["bomb_map"] = bombList;
@@ -41,60 +46,88 @@ public:
         //移动操作
         CROW_ROUTE(app, "/api/game/move").methods(crow::HTTPMethod::POST)
         ([](const crow::request& req) {
-            auto body = json::parse(req.body);
-            std::string uuid = body["game_uuid"];
-            int r = body["row"];
-            int c = body["col"];
-            std::string dir = body["direction"];
-            
-            //调用游戏对象的移动功能
-            json res = GameService::getInstance().processMove(uuid, r, c, dir);
-            return crow::response(Response::success(res).dump());
+            MoveRequest in;
+            if (auto err = decodeRequest(req.body, in)) return crow::response(400, Response::badRequest(err->field, err->msg));
+
+            //调用游戏对象的移动功能，结果直接写进当前线程的输出缓冲
+            JsonWriter out(JsonWriter::threadBuffer());
+            Response::beginSuccess(out);
+            GameService::getInstance().processMove(in.game_uuid, in.row, in.col, in.direction, in.seq, out);
+            Response::endSuccess(out);
+            return crow::response(out.str());
+        });
+
+        //批量指令：按顺序执行多条 move / use_item，只返回一次最终盘面
+        CROW_ROUTE(app, "/api/game/batch").methods(crow::HTTPMethod::POST)
+        ([](const crow::request& req) {
+            BatchRequest in;
+            if (auto err = decodeRequest(req.body, in)) return crow::response(400, Response::badRequest(err->field, err->msg));
+
+            //调用服务层逐条执行
+            JsonWriter out(JsonWriter::threadBuffer());
+            Response::beginSuccess(out);
+            ArenaJson err = GameService::getInstance().processBatch(in.game_uuid, in.commands, out);
+            if (!err.is_null()) return crow::response(200, Response::error(err["code"], err["msg"].get<std::string>()).dump());
+            Response::endSuccess(out);
+            return crow::response(out.str());
         });
 
         //PVE 开始
         CROW_ROUTE(app, "/api/pve/start").methods(crow::HTTPMethod::POST)
         ([](const crow::request& req) {
-            auto body = json::parse(req.body);
-            int uid = body.value("uid", 0);
-            int diff = body.value("difficulty", 1);
+            PveStartRequest in;
+            if (auto err = decodeRequest(req.body, in)) return crow::response(400, Response::badRequest(err->field, err->msg));
 
             //调用服务层开始 PVE 对战
-            json res = GameService::getInstance().startPVE(uid, diff);
+            ArenaJson res = GameService::getInstance().startPVE(in.uid, in.difficulty);
             return crow::response(Response::success(res).dump());
         });
 
         //PVP 匹配
         CROW_ROUTE(app, "/api/pvp/match").methods(crow::HTTPMethod::POST)
         ([](const crow::request& req) {
-            auto body = json::parse(req.body);
-            int uid = body.value("uid", 0);
+            UidRequest in;
+            if (auto err = decodeRequest(req.body, in)) return crow::response(400, Response::badRequest(err->field, err->msg));
 
             //调用服务层进行 PVP 匹配
-            json res = GameService::getInstance().joinPVP(uid);
+            ArenaJson res = GameService::getInstance().joinPVP(in.uid);
             return crow::response(Response::success(res).dump());
         });
 
         //对战状态查询 (PVP/PVE)
+        //带上次的 version (或 If-None-Match) 时，双方都没变化只返回 unchanged / 304
         CROW_ROUTE(app, "/api/pvp/status").methods(crow::HTTPMethod::POST)
         ([](const crow::request& req) {
-            auto body = json::parse(req.body);
-            std::string uuid = body["game_uuid"];
-
-            //调用服务层获取对战状态
-            json res = GameService::getInstance().getDualState(uuid);
-            return crow::response(Response::success(res).dump());
+            StatusRequest in;
+            if (auto err = decodeRequest(req.body, in)) return crow::response(400, Response::badRequest(err->field, err->msg));
+            std::string etag = req.get_header_value("If-None-Match");
+            bool byHeader = !in.version && etag.size() > 2;
+            std::string known = byHeader ? etag.substr(1, etag.size() - 2) : in.version.value_or("");
+
+            //调用服务层获取对战状态，直接写进当前线程的输出缓冲
+            JsonWriter out(JsonWriter::threadBuffer());
+            Response::beginSuccess(out);
+            DualState state = GameService::getInstance().getDualState(in.game_uuid, known, out);
+            Response::endSuccess(out);
+
+            crow::response resp;
+            if (!state.version.empty()) resp.set_header("ETag", "\"" + state.version + "\"");
+            if (byHeader && state.status == "unchanged") {
+                resp.code = 304;
+                return resp;
+            }
+            resp.body = out.str();
+            return resp;
         });
 
         //商城购买
         CROW_ROUTE(app, "/api/shop/buy").methods(crow::HTTPMethod::POST)
         ([](const crow::request& req) {
-            auto body = json::parse(req.body);
-            int uid = body.value("uid", 0);
-            std::string type = body["item_type"];
+            BuyRequest in;
+            if (auto err = decodeRequest(req.body, in)) return crow::response(400, Response::badRequest(err->field, err->msg));
 
             //调用服务层处理购买请求
-            json res = GameService::getInstance().buyItem(uid, type);
+            ArenaJson res = GameService::getInstance().buyItem(in.uid, in.item_type);
             if (res["code"] == 200) return crow::response(Response::success(res).dump());
             return crow::response(200, Response::error(400, res["msg"].get<std::string>()).dump());
         });
@@ -102,47 +135,69 @@ public:
         //使用道具
         CROW_ROUTE(app, "/api/game/use_item").methods(crow::HTTPMethod::POST)
         ([](const crow::request& req) {
-            auto body = json::parse(req.body);
-            std::string uuid = body["game_uuid"];
-            std::string type = body["item_type"];
-            int r = body.value("row", -1);
-            int c = body.value("col", -1);
+            UseItemRequest in;
+            if (auto err = decodeRequest(req.body, in)) return crow::response(400, Response::badRequest(err->field, err->msg));
 
             //调用服务层处理使用道具请求   
-            json res = GameService::getInstance().useItem(uuid, type, r, c);
+            ArenaJson res = GameService::getInstance().useItem(in.game_uuid, in.item_type, in.row, in.col);
             if (res["code"] == 200) return crow::response(Response::success(res).dump());
             return crow::response(200, Response::error(400, res["msg"].get<std::string>()).dump());
         });
 
         //排行榜接口
         CROW_ROUTE(app, "/api/rank").methods(crow::HTTPMethod::GET)
-        ([]() {
-
-            //调用服务层获取排行榜数据
-            json res = GameService::getInstance().getLeaderboard();
-            return crow::response(Response::success(res).dump());
+        ([](const crow::request& req) {
+            //不带参数：前几名，响应体只在榜单变化后重新生成
+            if (!req.url_params.get("offset") && !req.url_params.get("limit") && !req.url_params.get("uid") && !req.url_params.get("window")) {
+                return crow::response(*RankService::getInstance().topPayload());
+            }
+
+            //分页 + 自己的名次，window 选总榜/日榜/周榜
+            RankWindow window = RankWindow::All;
+            if (const char* w = req.url_params.get("window"); w && !parseRankWindow(w, window)) {
+                return crow::response(400, Response::badRequest("window", "window 取值非法"));
+            }
+            int offset = 0, limit = static_cast<int>(GameConfig::RANK_TOP_SIZE), uid = 0;
+            if (auto err = queryInt(req, "offset", offset, 0, INT_MAX)) return crow::response(400, Response::badRequest(err->field, err->msg));
+            if (auto err = queryInt(req, "limit", limit, 1, GameConfig::RANK_PAGE_MAX)) return crow::response(400, Response::badRequest(err->field, err->msg));
+            if (auto err = queryInt(req, "uid", uid, 0, INT_MAX)) return crow::response(400, Response::badRequest(err->field, err->msg));
+            return crow::response(Response::success(RankService::getInstance().page(window, offset, limit, uid)).dump());
         });
 
 
         //退出游戏接口
         CROW_ROUTE(app, "/api/game/quit").methods(crow::HTTPMethod::POST)
         ([](const crow::request& req) {
-            auto body = json::parse(req.body);
-            std::string uuid = body.value("game_uuid", "");
-            GameService::getInstance().quitGame(uuid);
+            GameRequest in;
+            if (auto err = decodeRequest(req.body, in)) return crow::response(400, Response::badRequest(err->field, err->msg));
+            GameService::getInstance().quitGame(in.game_uuid);
             return crow::response(Response::success().dump());
         });
 
         //取消 PVP 匹配接口
         CROW_ROUTE(app, "/api/pvp/cancel").methods(crow::HTTPMethod::POST)
         ([](const crow::request& req) {
-            auto body = json::parse(req.body);
-            int uid = body.value("uid", 0);
+            UidRequest in;
+            if (auto err = decodeRequest(req.body, in)) return crow::response(400, Response::badRequest(err->field, err->msg));
 
             //调用服务层取消匹配
-            bool success = GameService::getInstance().cancelMatch(uid);
+            bool success = GameService::getInstance().cancelMatch(in.uid);
             if(success) return crow::response(Response::success().dump());
             else return crow::response(200, Response::error(400, "当前不在匹配队列中").dump());
         });
     }
+
+private:
+    // GET 查询参数里的整数：缺省时保留 out 原值，不是整数或超出 [min, max] 时返回错误
+    static std::optional<DecodeError> queryInt(const crow::request& req, const char* name, int& out, int min, int max) {
+        const char* raw = req.url_params.get(name);
+        if (!raw) return std::nullopt;
+        char* end = nullptr;
+        errno = 0;
+        long v = std::strtol(raw, &end, 10);
+        if (end == raw || *end != '\0') return DecodeError{name, std::string(name) + " 类型错误"};
+        if (errno == ERANGE || v < min || v > max) return DecodeError{name, std::string(name) + " 超出范围"};
+        out = static_cast<int>(v);
+        return std::nullopt;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include "crow_all.h"
+#include "../services/PushService.h"
+#include "../utils/Response.h"
+#include "../utils/Request.h"
+
+class PushController {
+public:
+    template <typename T>
+    void registerRoutes(T& app) {
+
+        //对局实时推送 (PVP/PVE)，客户端连上后发送 {"game_uuid": "..."} 订阅
+        //推送内容与 /api/pvp/status 的响应完全一致，HTTP 轮询作为兜底保留
+        //(CROW_WEBSOCKET_ROUTE 宏在模板里无法使用，这里手动展开)
+        CROW_ROUTE(app, "/ws/match").template websocket<T>(&app)
+            .onmessage([](crow::websocket::connection& conn, const std::string& data, bool is_binary) {
+                GameRequest in;
+                if (decodeRequest(data, in) || in.game_uuid.empty()) return;
+                std::string uuid = in.game_uuid;
+
+                //订阅该对局的状态变化
+                PushService::getInstance().subscribe(&conn, uuid, [&conn](std::string msg) {
+                    conn.send_text(std::move(msg));
+                });
+            })
+            .onclose([](crow::websocket::connection& conn, const std::string&, uint16_t) {
+                PushService::getInstance().unsubscribe(&conn);
+            })
+            .onerror([](crow::websocket::connection& conn, const std::string&) {
+                PushService::getInstance().unsubscribe(&conn);
+            });
+    }
+};
@@ -0,0 +1,164 @@
+#pragma once
+#include "crow_all.h"
+#include "../utils/WebPage.h"
+#include <algorithm>
+
+class StaticController {
+public:
+    template <typename T>
+    void registerRoutes(T& app) {
+
+        // 读取并返回html
+        CROW_ROUTE(app, "/")
+        ([](const crow::request& req, crow::response& res) {
+            if (!serve("index.html", req, res)) {
+                res.code = 404;
+                res.write("Error: static/index.html not found. Please check your CMake copy configuration (or build with GAME_EMBED_STATIC).");
+            }
+            res.end();
+        });
+
+        // 静态资源路由
+        CROW_ROUTE(app, "/<string>")
+        ([](const crow::request& req, crow::response& res, std::string filename) {
+            if (!serve(filename, req, res)) {
+                res.code = 404;
+                res.write("File not found");
+            }
+            res.end();
+        });
+    }
+
+private:
+    enum class RangeResult { None, Ok, Unsatisfiable };
+
+    // 解析单段 Range：bytes=a-b / bytes=a- / bytes=-n，多段或格式不对时按整文件处理。
+    // 任何形式一次最多给 RANGE_CHUNK（Content-Range 里是实际给出的范围），客户端会接着请求后面的部分
+    static RangeResult parseRange(const std::string& header, size_t size, size_t& start, size_t& len) {
+        if (header.rfind("bytes=", 0) != 0 || header.find(',') != std::string::npos) return RangeResult::None;
+        std::string spec = header.substr(6);
+        size_t dash = spec.find('-');
+        if (dash == std::string::npos) return RangeResult::None;
+
+        std::string a = spec.substr(0, dash), b = spec.substr(dash + 1);
+        auto isNum = [](const std::string& v) { return !v.empty() && v.size() <= 18 && v.find_first_not_of("0123456789") == std::string::npos; };
+        if ((!a.empty() && !isNum(a)) || (!b.empty() && !isNum(b)) || (a.empty() && b.empty())) return RangeResult::None;
+
+        if (a.empty()) {
+            // 后缀形式：最后 n 个字节
+            size_t n = std::stoull(b);
+            if (n == 0 || size == 0) return RangeResult::Unsatisfiable;
+            start = size - std::min(n, size);
+            len = std::min(size - start, WebPage::RANGE_CHUNK);
+            return RangeResult::Ok;
+        }
+
+        start = std::stoull(a);
+        if (start >= size) return RangeResult::Unsatisfiable;
+        size_t end = size - 1;
+        if (!b.empty()) {
+            end = std::stoull(b);
+            if (end < start) return RangeResult::None;
+        }
+        len = std::min({end, size - 1, start + WebPage::RANGE_CHUNK - 1}) - start + 1;
+        return RangeResult::Ok;
+    }
+
+    // If-None-Match 是否命中：值可以是 "*" 或逗号分隔的 ETag 列表，按弱比较（忽略 W/ 前缀）
+    static bool etagListMatches(const std::string& header, const std::string& etag) {
+        size_t i = 0;
+        while (i < header.size()) {
+            char c = header[i];
+            if (c == ' ' || c == '\t' || c == ',') {
+                i++;
+                continue;
+            }
+            if (c == '*') return true;
+            if (header.compare(i, 2, "W/") == 0) i += 2;
+            if (i >= header.size() || header[i] != '"') return false; // 格式不对，按不匹配处理
+            size_t close = header.find('"', i + 1);
+            if (close == std::string::npos) return false;
+            if (header.compare(i, close - i + 1, etag) == 0) return true;
+            i = close + 1;
+        }
+        return false;
+    }
+
+    // 返回资源：命中 ETag / Last-Modified 时回 304，支持单段 Range (206)，
+    // 小文件从内存缓存按 Accept-Encoding 选择预压缩版本，大文件直接从磁盘分块发送
+    static bool serve(const std::string& name, const crow::request& req, crow::response& res) {
+        auto asset = WebPage::getInstance().find(name);
+        if (!asset) return false;
+
+        // 先选定要发的版本：Range 按原始字节计，只有整文件请求才用预压缩版本
+        std::string range = req.get_header_value("Range");
+        std::string enc = req.get_header_value("Accept-Encoding");
+        const std::string* body = &asset->body;
+        std::string encoding;
+        if (asset->in_memory && range.empty()) {
+            if (!asset->br_body.empty() && enc.find("br") != std::string::npos) {
+                body = &asset->br_body;
+                encoding = "br";
+            } else if (!asset->gzip_body.empty() && enc.find("gzip") != std::string::npos) {
+                body = &asset->gzip_body;
+                encoding = "gzip";
+            }
+        }
+
+        // 强 ETag 每个编码版本各不相同（"hash-size" -> "hash-size-br"），缓存和 If-Range 不会把几个版本混在一起
+        std::string etag = asset->etag;
+        if (encoding == "br") etag.insert(etag.size() - 1, "-br");
+        else if (encoding == "gzip") etag.insert(etag.size() - 1, "-gz");
+
+        res.set_header("ETag", etag);
+        res.set_header("Last-Modified", asset->last_modified);
+        res.set_header("Cache-Control", "no-cache");
+        res.set_header("Vary", "Accept-Encoding");
+        res.set_header("Accept-Ranges", "bytes");
+
+        std::string inm = req.get_header_value("If-None-Match");
+        std::string ims = req.get_header_value("If-Modified-Since");
+        if ((!inm.empty() && etagListMatches(inm, etag)) || (inm.empty() && !ims.empty() && ims == asset->last_modified)) {
+            res.code = 304;
+            return true;
+        }
+
+        // If-Range 不匹配说明客户端手里的是旧版本，直接给整个文件
+        std::string ifRange = req.get_header_value("If-Range");
+        if (!range.empty() && (ifRange.empty() || ifRange == asset->etag || ifRange == asset->last_modified)) {
+            size_t start = 0, len = 0;
+            RangeResult r = parseRange(range, asset->size, start, len);
+            if (r == RangeResult::Unsatisfiable) {
+                res.code = 416;
+                res.set_header("Content-Range", "bytes */" + std::to_string(asset->size));
+                return true;
+            }
+            std::string part;
+            if (r == RangeResult::Ok && !WebPage::slice(*asset, start, len, part)) {
+                // 文件正在被替换，热更新马上会跟上，让客户端稍后重试
+                res.code = 503;
+                res.set_header("Retry-After", "1");
+                return true;
+            }
+            if (r == RangeResult::Ok) {
+                res.code = 206;
+                res.set_header("Content-Type", asset->mime);
+                res.set_header("Content-Range", "bytes " + std::to_string(start) + "-" + std::to_string(start + len - 1) +
+                                                "/" + std::to_string(asset->size));
+                res.write(part);
+                return true;
+            }
+        }
+
+        // 大文件：交给 Crow 按 16KB 分块从磁盘写出，不在内存里拼整个响应体
+        if (!asset->in_memory) {
+            res.set_static_file_info_unsafe(asset->path, asset->mime);
+            return true;
+        }
+
+        res.set_header("Content-Type", asset->mime);
+        if (!encoding.empty()) res.set_header("Content-Encoding", encoding);
+        res.write(*body);
+        return true;
+    }
+};
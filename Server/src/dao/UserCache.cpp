@@ -0,0 +1,48 @@
+#include "UserCache.h"
+#include "WriteBehind.h"
+
+// 单例实现
+UserCache& UserCache::getInstance() {
+    static UserCache instance;
+    return instance;
+}
+
+bool UserCache::getUser(int uid, User& out) {
+    if (uid <= 0) return false;
+    Shard& s = shard(uid);
+    uint64_t writesBefore;
+    {
+        std::lock_guard<std::mutex> l(s.mutex);
+        auto it = s.index.find(uid);
+        if (it != s.index.end()) {
+            s.lru.splice(s.lru.begin(), s.lru, it->second); // 挪到最前
+            out = *it->second;
+            return true;
+        }
+        writesBefore = s.writes;
+    }
+
+    // 未命中：读库不占分片锁。先提交积压的写缓冲，读到的才是完整的值
+    WriteBehind::getInstance().flush(uid);
+    if (!userDao.getUserById(uid, out)) return false;
+
+    std::lock_guard<std::mutex> l(s.mutex);
+    if (s.writes != writesBefore || s.index.count(uid)) return true; // 读库期间有写入，这份可能已旧，不缓存
+    s.lru.push_front(out);
+    s.index[uid] = s.lru.begin();
+    if (s.lru.size() > GameConfig::USER_CACHE_CAPACITY / SHARD_COUNT) {
+        s.index.erase(s.lru.back().uid);
+        s.lru.pop_back();
+    }
+    return true;
+}
+
+void UserCache::invalidate(int uid) {
+    Shard& s = shard(uid);
+    std::lock_guard<std::mutex> l(s.mutex);
+    s.writes++;
+    auto it = s.index.find(uid);
+    if (it == s.index.end()) return;
+    s.lru.erase(it->second);
+    s.index.erase(it);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "UserDao.h"
+#include "../models/User.h"
+#include "../config/GameConfig.h"
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+// 用户资料的内存缓存：按 uid 分片加锁，每片 LRU 淘汰，总条数有上限。
+// 写入时同步更新缓存（写缓冲里的增量直接改缓存；同步落库的改动让缓存失效），读优先走缓存
+class UserCache {
+public:
+    // 单例获取
+    static UserCache& getInstance();
+
+    // 禁止拷贝
+    UserCache(const UserCache&) = delete;
+    void operator=(const UserCache&) = delete;
+
+    // 取用户资料：命中直接返回，未命中先提交该用户积压的写缓冲再读库并放进缓存。用户不存在返回 false
+    bool getUser(int uid, User& out);
+
+    // 在分片锁内修改缓存里的用户（未缓存时传入 nullptr）。fn 里可以顺带登记写缓冲，
+    // 这样"改缓存 + 排队落库"对并发的读库加载来说是一步完成的
+    template <typename Fn>
+    void update(int uid, Fn fn) {
+        Shard& s = shard(uid);
+        std::lock_guard<std::mutex> l(s.mutex);
+        s.writes++;
+        auto it = s.index.find(uid);
+        fn(it == s.index.end() ? nullptr : &*it->second);
+    }
+
+    // 数据库已经直接改过（同步写），丢掉缓存，下次读时重新加载
+    void invalidate(int uid);
+
+private:
+    UserCache() = default; // 私有构造
+
+    UserDao userDao;
+
+    inline static const size_t SHARD_COUNT = 16;
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<User> lru; // 最近用过的在前
+        std::unordered_map<int, std::list<User>::iterator> index;
+        uint64_t writes = 0; // 本片的写次数，加载期间有写入就不缓存读到的旧值
+    };
+    std::array<Shard, SHARD_COUNT> shards;
+
+    Shard& shard(int uid) { return shards[static_cast<unsigned>(uid) % SHARD_COUNT]; }
+};
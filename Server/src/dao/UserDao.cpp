@@ -1,4 +1,176 @@
 #include "UserDao.h"
+#include "UserCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 语句表，顺序与 UserDao::Statement 一致
+const char* const SQL[] = {
+    "SELECT * FROM users WHERE account = :acc AND password = :pwd",                             // Login
+    "SELECT uid FROM users WHERE account = :acc",                                                // FindAccount
+    "INSERT INTO users (account, password, nickname, max_level, coins) VALUES (:acc, :pwd, :nick, 1, 500)", // InsertUser
+    "SELECT * FROM users WHERE uid = :uid",                                                      // UserById
+    "UPDATE users SET max_score = :score WHERE uid = :uid AND max_score < :score",               // UpdateMaxScore
+    "SELECT max_level FROM users WHERE uid = :uid",                                              // SelectMaxLevel
+    "UPDATE users SET max_level = max_level + 1, coins = coins + 100 WHERE uid = :uid",          // UnlockLevel
+    "SELECT nickname FROM users WHERE uid = :uid",                                               // Nickname
+    "SELECT uid, nickname, max_score FROM users WHERE max_score > 0",                            // Scores（0 分的玩家不上榜）
+    "UPDATE users SET coins = coins - :cost, item_bomb = item_bomb + 1 WHERE uid = :uid AND coins >= :cost",     // BuyItemBomb
+    "UPDATE users SET coins = coins - :cost, item_reset = item_reset + 1 WHERE uid = :uid AND coins >= :cost",   // BuyItemReset
+    "UPDATE users SET coins = coins - :cost, item_freeze = item_freeze + 1 WHERE uid = :uid AND coins >= :cost", // BuyItemFreeze
+    "UPDATE users SET item_bomb = item_bomb - 1 WHERE uid = :uid AND item_bomb >= 1",            // UseItemBomb
+    "UPDATE users SET item_reset = item_reset - 1 WHERE uid = :uid AND item_reset >= 1",         // UseItemReset
+    "UPDATE users SET item_freeze = item_freeze - 1 WHERE uid = :uid AND item_freeze >= 1",      // UseItemFreeze
+    "UPDATE users SET coins = coins + :coins, item_bomb = item_bomb + :bomb, "
+    "item_reset = item_reset + :reset, item_freeze = item_freeze + :freeze, "
+    "max_score = MAX(max_score, :score) WHERE uid = :uid",                                       // ApplyPending
+    "DELETE FROM rank_snapshots WHERE board = :board AND period = :period",                      // SnapshotDelete
+    "INSERT INTO rank_snapshots (board, period, rank, uid, score) VALUES (:board, :period, :rank, :uid, :score)", // SnapshotInsert
+    "SELECT s.uid, u.nickname, s.score FROM rank_snapshots s JOIN users u ON u.uid = s.uid "
+    "WHERE s.board = :board AND s.period = :period",                                             // SnapshotLoad
+};
+
+// 一个线程持有的连接和它上面编译好的语句，线程退出时关闭并从 Qt 的连接表里移除
+struct ThreadConnection {
+    QString name;
+    std::vector<std::unique_ptr<QSqlQuery>> statements; // 按语句编号缓存
+
+    ~ThreadConnection() {
+        if (name.isEmpty()) return;
+        statements.clear(); // 语句要先于连接释放
+        {
+            QSqlDatabase db = QSqlDatabase::database(name, false);
+            db.close();
+        } // removeDatabase 之前不能还有 QSqlDatabase 对象引用这个连接
+        QSqlDatabase::removeDatabase(name);
+    }
+};
+
+ThreadConnection& threadConnection() {
+    thread_local ThreadConnection conn;
+    return conn;
+}
+
+std::atomic<int> connectionCount{0};
+
+// 新连接的设置。WAL 下读不阻塞写、写不阻塞读；synchronous=NORMAL 在 WAL 下只在检查点时 fsync，
+// 掉电最多丢最后几个事务，不会损坏数据库
+void configureConnection(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    if (!q.exec("PRAGMA journal_mode=WAL") || !q.next() || q.value(0).toString().toLower() != "wal") {
+        std::cerr << "Warning: database is not in WAL mode, writers will block readers" << std::endl;
+    }
+    q.exec("PRAGMA synchronous=NORMAL");
+    q.exec(QString("PRAGMA cache_size=-%1").arg(GameConfig::DB_CACHE_SIZE_KB));
+    q.exec(QString("PRAGMA mmap_size=%1").arg(GameConfig::DB_MMAP_SIZE));
+    q.exec("PRAGMA temp_store=MEMORY");
+    q.exec("PRAGMA wal_autocheckpoint=0"); // 检查点交给后台线程，写请求不再顺带做
+}
+
+bool isBusy(const QSqlError& err) {
+    int code = err.nativeErrorCode().toInt() & 0xFF; // 扩展错误码的低 8 位是主错误码
+    return code == 5 || code == 6; // SQLITE_BUSY / SQLITE_LOCKED
+}
+
+// 执行语句。驱动已经按 busy timeout 等过锁，仍然 SQLITE_BUSY 的（如 WAL 读事务升级成写事务时
+// 快照已过期，SQLite 不会等待直接返回）退避后再试几次，避免静默丢掉资产更新
+bool execRetry(QSqlQuery& q) {
+    for (int attempt = 0;; attempt++) {
+        if (q.exec()) return true;
+        if (!isBusy(q.lastError()) || attempt >= GameConfig::DB_BUSY_RETRIES) break;
+        q.finish();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10 << attempt));
+    }
+    std::cerr << "Error: query failed: " << q.lastError().text().toStdString() << std::endl;
+    return false;
+}
+
+// 后台检查点线程
+std::mutex checkpointMutex;
+std::condition_variable checkpointCv;
+std::thread checkpointThread;
+bool checkpointRunning = false;
+
+} // namespace
+
+QSqlDatabase UserDao::getDBConnection() {
+    ThreadConnection& conn = threadConnection();
+    if (conn.name.isEmpty()) {
+        conn.name = QString("game-db-%1").arg(connectionCount.fetch_add(1));
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", conn.name);
+        db.setDatabaseName(QString::fromStdString(ServerConfig::getInstance().db_path));
+        db.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1").arg(GameConfig::DB_BUSY_TIMEOUT_MS));
+    }
+
+    QSqlDatabase db = QSqlDatabase::database(conn.name, false);
+    if (!db.isOpen()) {
+        if (db.open()) {
+            configureConnection(db);
+        } else {
+            // 下次调用再重试
+            std::cerr << "Error: cannot open database: " << db.lastError().text().toStdString() << std::endl;
+        }
+    }
+    return db;
+}
+
+UserDao::PreparedQuery UserDao::prepared(Statement id) {
+    static_assert(sizeof(SQL) / sizeof(SQL[0]) == static_cast<size_t>(Statement::Count), "SQL table out of sync");
+
+    QSqlDatabase db = getDBConnection();
+    if (!db.isOpen()) return PreparedQuery(nullptr);
+
+    ThreadConnection& conn = threadConnection();
+    if (conn.statements.empty()) conn.statements.resize(static_cast<size_t>(Statement::Count));
+
+    auto& slot = conn.statements[static_cast<size_t>(id)];
+    if (!slot) {
+        auto q = std::make_unique<QSqlQuery>(db);
+        q->setForwardOnly(true); // 结果只顺序读一遍，不需要缓存行
+        if (!q->prepare(SQL[static_cast<size_t>(id)])) {
+            std::cerr << "Error: cannot prepare statement: " << q->lastError().text().toStdString() << std::endl;
+            return PreparedQuery(nullptr);
+        }
+        slot = std::move(q);
+    }
+    return PreparedQuery(slot.get());
+}
+
+UserDao::PreparedQuery UserDao::prepared(ItemStatement group, AssetColumn item) {
+    // 按 AssetColumn 的顺序，Count 表示该列没有对应语句
+    static const Statement TABLE[][ASSET_COLUMN_COUNT] = {
+        {Statement::Count, Statement::BuyItemBomb, Statement::BuyItemReset, Statement::BuyItemFreeze}, // Buy
+        {Statement::Count, Statement::UseItemBomb, Statement::UseItemReset, Statement::UseItemFreeze}, // Use
+    };
+    Statement id = TABLE[static_cast<size_t>(group)][static_cast<size_t>(item)];
+    if (id == Statement::Count) {
+        std::cerr << "Error: no item statement for asset column " << static_cast<int>(item) << std::endl;
+        return PreparedQuery(nullptr);
+    }
+    return prepared(id);
+}
+
+void UserDao::readUser(const QSqlQuery& query, User& user) {
+    user.uid = query.value("uid").toInt();
+    user.account = query.value("account").toString().toStdString();
+    user.password = query.value("password").toString().toStdString();
+    user.nickname = query.value("nickname").toString().toStdString();
+    user.coins = query.value("coins").toInt();
+    user.max_score = query.value("max_score").toInt();
+    int lvl = query.value("max_level").toInt();
+    user.max_level = (lvl < 1) ? 1 : lvl;
+    user.item_bomb = query.value("item_bomb").toInt();
+    user.item_reset = query.value("item_reset").toInt();
+    user.item_freeze = query.value("item_freeze").toInt();
+}
 
 UserDao::UserDao() {
     initDBTable();
@@ -6,7 +178,7 @@ UserDao::UserDao() {
 
 void UserDao::initDBTable() {
     QSqlDatabase db = getDBConnection();
-    if (db.open()) {
+    if (db.isOpen()) {
         QSqlQuery query(db);
         bool success = query.exec(
             "CREATE TABLE IF NOT EXISTS users ("
@@ -30,186 +202,123 @@ void UserDao::initDBTable() {
             query.exec("ALTER TABLE users ADD COLUMN item_reset INTEGER DEFAULT 0");
             query.exec("ALTER TABLE users ADD COLUMN item_freeze INTEGER DEFAULT 0");
         }
+
+        // 日榜/周榜的快照，period 是周期编号（见 RankService）
+        query.exec(
+            "CREATE TABLE IF NOT EXISTS rank_snapshots ("
+            "board TEXT NOT NULL, "
+            "period INTEGER NOT NULL, "
+            "rank INTEGER NOT NULL, "
+            "uid INTEGER NOT NULL, "
+            "score INTEGER NOT NULL, "
+            "PRIMARY KEY (board, period, uid)"
+            ") WITHOUT ROWID"
+        );
     }
-    db.close();
 }
 
 bool UserDao::login(const std::string& account, const std::string& password, User& user) {
-    QSqlDatabase db = getDBConnection();
-    if (!db.open()) return false;
-
-    QSqlQuery query(db);
-    query.prepare("SELECT * FROM users WHERE account = :acc AND password = :pwd");
-    query.bindValue(":acc", QString::fromStdString(account));
-    query.bindValue(":pwd", QString::fromStdString(password));
-
-    bool success = false;
-    if (query.exec() && query.next()) {
-        user.uid = query.value("uid").toInt();
-        user.account = query.value("account").toString().toStdString();
-        user.password = query.value("password").toString().toStdString();
-        user.nickname = query.value("nickname").toString().toStdString();
-        user.coins = query.value("coins").toInt();
-        user.max_score = query.value("max_score").toInt();
-        int lvl = query.value("max_level").toInt();
-        user.max_level = (lvl < 1) ? 1 : lvl;
-        user.item_bomb = query.value("item_bomb").toInt();
-        user.item_reset = query.value("item_reset").toInt();
-        user.item_freeze = query.value("item_freeze").toInt();
-        success = true;
-    }
-    db.close();
-    return success;
+    PreparedQuery query = prepared(Statement::Login);
+    if (!query) return false;
+
+    query->bindValue(":acc", QString::fromStdString(account));
+    query->bindValue(":pwd", QString::fromStdString(password));
+    if (!execRetry(*query) || !query->next()) return false;
+
+    readUser(*query, user);
+    return true;
 }
 
 bool UserDao::registerUser(const std::string& account, const std::string& password, const std::string& nickname) {
-    QSqlDatabase db = getDBConnection();
-    if (!db.open()) return false;
-
-    QSqlQuery query(db);
-    query.prepare("SELECT uid FROM users WHERE account = :acc");
-    query.bindValue(":acc", QString::fromStdString(account));
-    if (query.exec() && query.next()) {
-        db.close();
-        return false; // 账号已存在
+    {
+        PreparedQuery query = prepared(Statement::FindAccount);
+        if (!query) return false;
+        query->bindValue(":acc", QString::fromStdString(account));
+        if (execRetry(*query) && query->next()) {
+            return false; // 账号已存在
+        }
     }
 
-    query.prepare("INSERT INTO users (account, password, nickname, max_level, coins) VALUES (:acc, :pwd, :nick, 1, 500)");
-    query.bindValue(":acc", QString::fromStdString(account));
-    query.bindValue(":pwd", QString::fromStdString(password));
-    query.bindValue(":nick", QString::fromStdString(nickname));
-
-    bool success = query.exec();
-    db.close();
-    return success;
+    PreparedQuery query = prepared(Statement::InsertUser);
+    if (!query) return false;
+    query->bindValue(":acc", QString::fromStdString(account));
+    query->bindValue(":pwd", QString::fromStdString(password));
+    query->bindValue(":nick", QString::fromStdString(nickname));
+    return execRetry(*query);
 }
 
 bool UserDao::getUserById(int uid, User& user) {
-    QSqlDatabase db = getDBConnection();
-    if (!db.open()) return false;
-
-    QSqlQuery query(db);
-    query.prepare("SELECT * FROM users WHERE uid = :uid");
-    query.bindValue(":uid", uid);
-
-    bool success = false;
-    if (query.exec() && query.next()) {
-        user.uid = uid;
-        user.account = query.value("account").toString().toStdString();
-        user.password = query.value("password").toString().toStdString();
-        user.nickname = query.value("nickname").toString().toStdString();
-        user.coins = query.value("coins").toInt();
-        user.max_score = query.value("max_score").toInt();
-        int lvl = query.value("max_level").toInt();
-        user.max_level = (lvl < 1) ? 1 : lvl;
-        user.item_bomb = query.value("item_bomb").toInt();
-        user.item_reset = query.value("item_reset").toInt();
-        user.item_freeze = query.value("item_freeze").toInt();
-        success = true;
-    }
-    db.close();
-    return success;
+    PreparedQuery query = prepared(Statement::UserById);
+    if (!query) return false;
+
+    query->bindValue(":uid", uid);
+    if (!execRetry(*query) || !query->next()) return false;
+
+    readUser(*query, user);
+    user.uid = uid;
+    return true;
 }
 
-bool UserDao::updateAsset(int uid, const std::string& type, int delta) {
-    if (uid <= 0) return false;
+bool UserDao::purchaseItem(int uid, AssetColumn item, int cost) {
+    if (uid <= 0 || cost < 0) return false;
 
-    QString connName = QUuid::createUuid().toString();
-    bool success = false;
+    // 余额检查和扣款在同一条语句里，并发购买不会把金币扣成负数
+    PreparedQuery q = prepared(ItemStatement::Buy, item);
+    if (!q) return false;
+    q->bindValue(":cost", cost);
+    q->bindValue(":uid", uid);
+    bool bought = execRetry(*q) && q->numRowsAffected() > 0;
+    if (bought) UserCache::getInstance().invalidate(uid); // 落库之后再失效，避免并发加载把旧值放回缓存
+    return bought;
+}
 
-    {
-        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connName);
-        db.setDatabaseName("game.db");
-        if (db.open()) {
-            QSqlQuery q(db);
-
-            // 如果是扣钱/扣道具，先查够不够
-            if (delta < 0) {
-                QString sql = QString("SELECT %1 FROM users WHERE uid = :uid").arg(QString::fromStdString(type));
-                q.prepare(sql);
-                q.bindValue(":uid", uid);
-                if (q.exec() && q.next()) {
-                    if (q.value(0).toInt() + delta < 0) {
-                        // 余额不足
-                        db.close();
-                        QSqlDatabase::removeDatabase(connName);
-                        return false;
-                    }
-                } else {
-                    // 查不到用户
-                    db.close();
-                    QSqlDatabase::removeDatabase(connName);
-                    return false;
-                }
-            }
+bool UserDao::consumeItem(int uid, AssetColumn item) {
+    if (uid <= 0) return false;
 
-            // 执行更新
-            QString sql = QString("UPDATE users SET %1 = %1 + :delta WHERE uid = :uid").arg(QString::fromStdString(type));
-            q.prepare(sql);
-            q.bindValue(":delta", delta);
-            q.bindValue(":uid", uid);
-            success = q.exec();
-            db.close();
-        }
-    }
-    QSqlDatabase::removeDatabase(connName);
-    return success;
+    PreparedQuery q = prepared(ItemStatement::Use, item);
+    if (!q) return false;
+    q->bindValue(":uid", uid);
+    bool used = execRetry(*q) && q->numRowsAffected() > 0;
+    if (used) UserCache::getInstance().invalidate(uid);
+    return used;
 }
 
 bool UserDao::updateMaxScore(int uid, int current_score) {
     if (uid <= 0) return false;
-    bool isNewRecord = false;
 
-    QString connName = QUuid::createUuid().toString();
-    {
-        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connName);
-        db.setDatabaseName("game.db");
-        if (db.open()) {
-            QSqlQuery q(db);
-            // 只在当前分更高时更新
-            q.prepare("UPDATE users SET max_score = :score WHERE uid = :uid AND max_score < :score");
-            q.bindValue(":score", current_score);
-            q.bindValue(":uid", uid);
-            if (q.exec()) {
-                if (q.numRowsAffected() > 0) isNewRecord = true;
-            }
-            db.close();
-        }
-    }
-    QSqlDatabase::removeDatabase(connName);
+    // 只在当前分更高时更新
+    PreparedQuery q = prepared(Statement::UpdateMaxScore);
+    if (!q) return false;
+    q->bindValue(":score", current_score);
+    q->bindValue(":uid", uid);
+    bool isNewRecord = execRetry(*q) && q->numRowsAffected() > 0;
+    if (isNewRecord) UserCache::getInstance().invalidate(uid);
     return isNewRecord;
 }
 
 bool UserDao::updateMaxLevel(int uid, int level_passed) {
     if (uid <= 0) return false;
-    bool unlocked = false;
 
-    QString connName = QUuid::createUuid().toString();
     {
-        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connName);
-        db.setDatabaseName("game.db");
-        if (db.open()) {
-            QSqlQuery q(db);
-            // 查当前最大关卡
-            q.prepare("SELECT max_level FROM users WHERE uid = :uid");
-            q.bindValue(":uid", uid);
-            if (q.exec() && q.next()) {
-                int currentMax = q.value(0).toInt();
-                if (currentMax < 1) currentMax = 1;
-
-                // 只有刚好通关当前最大关卡时，才解锁下一关
-                if (level_passed == currentMax) {
-                    QSqlQuery updateQ(db);
-                    // 通关奖励 100 金币 + 解锁
-                    updateQ.prepare("UPDATE users SET max_level = max_level + 1, coins = coins + 100 WHERE uid = :uid");
-                    updateQ.bindValue(":uid", uid);
-                    if (updateQ.exec()) unlocked = true;
-                }
-            }
-            db.close();
-        }
+        // 查当前最大关卡
+        PreparedQuery q = prepared(Statement::SelectMaxLevel);
+        if (!q) return false;
+        q->bindValue(":uid", uid);
+        if (!execRetry(*q) || !q->next()) return false;
+
+        int currentMax = q->value(0).toInt();
+        if (currentMax < 1) currentMax = 1;
+
+        // 只有刚好通关当前最大关卡时，才解锁下一关
+        if (level_passed != currentMax) return false;
     }
-    QSqlDatabase::removeDatabase(connName);
+
+    // 通关奖励 100 金币 + 解锁
+    PreparedQuery updateQ = prepared(Statement::UnlockLevel);
+    if (!updateQ) return false;
+    updateQ->bindValue(":uid", uid);
+    bool unlocked = execRetry(*updateQ);
+    UserCache::getInstance().invalidate(uid);
     return unlocked;
 }
 
@@ -217,44 +326,148 @@ std::string UserDao::getNicknameFromDB(int uid) {
     if (uid == 0) return "Guest";
 
     std::string nick = "Player";
-    QString connName = QUuid::createUuid().toString();
+    PreparedQuery q = prepared(Statement::Nickname);
+    if (!q) return nick;
+
+    q->bindValue(":uid", uid);
+    if (execRetry(*q) && q->next()) {
+        nick = q->value(0).toString().toStdString();
+    }
+    return nick;
+}
+
+bool UserDao::applyPending(const std::vector<PendingWrite>& batch) {
+    if (batch.empty()) return true;
+    QSqlDatabase db = getDBConnection();
+    if (!db.isOpen() || !db.transaction()) return false;
 
+    bool ok = true;
     {
-        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connName);
-        db.setDatabaseName("game.db");
-        if (db.open()) {
-            QSqlQuery q(db);
-            q.prepare("SELECT nickname FROM users WHERE uid = :uid");
-            q.bindValue(":uid", uid);
-            if (q.exec() && q.next()) {
-                nick = q.value(0).toString().toStdString();
-            }
-            db.close();
+        PreparedQuery q = prepared(Statement::ApplyPending);
+        ok = static_cast<bool>(q);
+        for (size_t i = 0; ok && i < batch.size(); i++) {
+            const PendingWrite& w = batch[i];
+            q->bindValue(":coins", w.deltas[static_cast<int>(AssetColumn::Coins)]);
+            q->bindValue(":bomb", w.deltas[static_cast<int>(AssetColumn::ItemBomb)]);
+            q->bindValue(":reset", w.deltas[static_cast<int>(AssetColumn::ItemReset)]);
+            q->bindValue(":freeze", w.deltas[static_cast<int>(AssetColumn::ItemFreeze)]);
+            q->bindValue(":score", w.max_score);
+            q->bindValue(":uid", w.uid);
+            ok = execRetry(*q);
         }
+    } // 提交前先 finish 掉语句
+
+    if (ok && db.commit()) return true;
+    db.rollback();
+    return false;
+}
+
+std::vector<RankEntry> UserDao::getScores() {
+    std::vector<RankEntry> list;
+    PreparedQuery q = prepared(Statement::Scores);
+    if (!q || !execRetry(*q)) return list;
+
+    while (q->next()) {
+        list.push_back({
+            q->value("uid").toInt(),
+            q->value("nickname").toString().toStdString(),
+            q->value("max_score").toInt()
+        });
     }
-    QSqlDatabase::removeDatabase(connName);
-    return nick;
+    return list;
 }
 
-json UserDao::getLeaderboard() {
-    json list = json::array();
-    QString connName = QUuid::createUuid().toString();
+bool UserDao::saveRankSnapshot(const std::string& board, int period, const std::vector<RankEntry>& entries) {
+    QSqlDatabase db = getDBConnection();
+    if (!db.isOpen() || !db.transaction()) return false;
 
+    bool ok = true;
     {
-        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connName);
-        db.setDatabaseName("game.db");
-        if (db.open()) {
-            QSqlQuery q(db);
-            q.exec("SELECT nickname, max_score FROM users ORDER BY max_score DESC LIMIT 10");
-            while (q.next()) {
-                list.push_back({
-                    {"nickname", q.value("nickname").toString().toStdString()},
-                    {"score", q.value("max_score").toInt()}
-                });
-            }
-            db.close();
+        PreparedQuery del = prepared(Statement::SnapshotDelete);
+        ok = static_cast<bool>(del);
+        if (ok) {
+            del->bindValue(":board", QString::fromStdString(board));
+            del->bindValue(":period", period);
+            ok = execRetry(*del);
+        }
+
+        PreparedQuery ins = prepared(Statement::SnapshotInsert);
+        ok = ok && static_cast<bool>(ins);
+        int rank = 1;
+        for (size_t i = 0; ok && i < entries.size(); i++) {
+            if (i > 0 && entries[i].score != entries[i - 1].score) rank = static_cast<int>(i) + 1; // 同分同名次
+            ins->bindValue(":board", QString::fromStdString(board));
+            ins->bindValue(":period", period);
+            ins->bindValue(":rank", rank);
+            ins->bindValue(":uid", entries[i].uid);
+            ins->bindValue(":score", entries[i].score);
+            ok = execRetry(*ins);
         }
+    } // 提交前先 finish 掉语句
+
+    if (ok && db.commit()) return true;
+    db.rollback();
+    return false;
+}
+
+std::vector<RankEntry> UserDao::loadRankSnapshot(const std::string& board, int period) {
+    std::vector<RankEntry> list;
+    PreparedQuery q = prepared(Statement::SnapshotLoad);
+    if (!q) return list;
+    q->bindValue(":board", QString::fromStdString(board));
+    q->bindValue(":period", period);
+    if (!execRetry(*q)) return list;
+
+    while (q->next()) {
+        list.push_back({
+            q->value("uid").toInt(),
+            q->value("nickname").toString().toStdString(),
+            q->value("score").toInt()
+        });
     }
-    QSqlDatabase::removeDatabase(connName);
     return list;
-}
\ No newline at end of file
+}
+
+void UserDao::startCheckpointer() {
+    std::lock_guard<std::mutex> l(checkpointMutex);
+    if (checkpointRunning) return;
+    checkpointRunning = true;
+    checkpointThread = std::thread([] {
+        std::unique_lock<std::mutex> lk(checkpointMutex);
+        while (checkpointRunning) {
+            checkpointCv.wait_for(lk, std::chrono::milliseconds(GameConfig::DB_CHECKPOINT_INTERVAL_MS),
+                                  [] { return !checkpointRunning; });
+            if (!checkpointRunning) break;
+            lk.unlock();
+
+            // PASSIVE 不等读者，能合并多少合并多少；WAL 太大时再做一次截断（会按 busy timeout 等读者读完）
+            QSqlDatabase db = getDBConnection(); // 检查点线程自己的连接
+            if (db.isOpen()) {
+                QSqlQuery q(db);
+                if (q.exec("PRAGMA wal_checkpoint(PASSIVE)") && q.next() && q.value(1).toInt() > GameConfig::DB_WAL_TRUNCATE_PAGES) {
+                    q.finish();
+                    q.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+                }
+            }
+            lk.lock();
+        }
+        lk.unlock();
+
+        // 退出前把 WAL 全部合并回主库
+        QSqlDatabase db = getDBConnection();
+        QSqlQuery q(db);
+        if (db.isOpen() && !q.exec("PRAGMA wal_checkpoint(TRUNCATE)")) {
+            std::cerr << "Warning: final checkpoint failed: " << q.lastError().text().toStdString() << std::endl;
+        }
+    });
+}
+
+void UserDao::stopCheckpointer() {
+    {
+        std::lock_guard<std::mutex> l(checkpointMutex);
+        if (!checkpointRunning) return;
+        checkpointRunning = false;
+        checkpointCv.notify_one();
+    }
+    if (checkpointThread.joinable()) checkpointThread.join();
+}
@@ -1,20 +1,83 @@
 #pragma once
 #include <QtSql>
-#include <QUuid>
 #include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
 #include "../models/User.h"
+#include "../config/ServerConfig.h"
+#include "../config/GameConfig.h"
 
 using json = nlohmann::json;
 
+// 按增量修改的资产列。SQL 里的列名只来自这个白名单，调用方的字符串不会拼进 SQL
+enum class AssetColumn { Coins, ItemBomb, ItemReset, ItemFreeze };
+inline constexpr int ASSET_COLUMN_COUNT = 4;
+
+// 道具类型 (bomb / reset / freeze) 对应的库存列，未知道具返回 false
+inline bool parseItemColumn(const std::string& itemType, AssetColumn& out) {
+    if (itemType == "bomb") out = AssetColumn::ItemBomb;
+    else if (itemType == "reset") out = AssetColumn::ItemReset;
+    else if (itemType == "freeze") out = AssetColumn::ItemFreeze;
+    else return false;
+    return true;
+}
+
+// 写缓冲里攒下的一个用户的改动：各资产列的累计增量 + 本窗口内的最高分
+struct PendingWrite {
+    int uid = 0;
+    int max_score = 0; // 0 表示没有新分数
+    int deltas[ASSET_COLUMN_COUNT] = {}; // 按 AssetColumn 的顺序
+};
+
+// 排行榜上的一条
+struct RankEntry {
+    int uid = 0;
+    std::string nickname;
+    int score = 0;
+};
+
 class UserDao {
 private:
-    QSqlDatabase getDBConnection() {
-        QString connectionName = QUuid::createUuid().toString();
-        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
-        db.setDatabaseName("game.db");
-        return db;
-    }
+    // 当前线程的数据库连接：第一次使用时打开，之后一直复用，线程退出时关闭。
+    // Qt 的数据库连接只能在创建它的线程里使用，所以按线程各持一个。打开失败时返回未打开的连接
+    static QSqlDatabase getDBConnection();
+
+    // 预编译语句编号，SQL 文本见 UserDao.cpp 的语句表
+    enum class Statement {
+        Login, FindAccount, InsertUser, UserById,
+        UpdateMaxScore, SelectMaxLevel, UnlockLevel, Nickname, Scores,
+        BuyItemBomb, BuyItemReset, BuyItemFreeze,
+        UseItemBomb, UseItemReset, UseItemFreeze,
+        ApplyPending,
+        SnapshotDelete, SnapshotInsert, SnapshotLoad,
+        Count
+    };
+
+    // 缓存在连接上的预编译语句，析构时 finish() 释放结果集（语句本身留给下次用）
+    class PreparedQuery {
+    public:
+        explicit PreparedQuery(QSqlQuery* q) : q(q) {}
+        PreparedQuery(PreparedQuery&& o) noexcept : q(o.q) { o.q = nullptr; }
+        PreparedQuery(const PreparedQuery&) = delete;
+        void operator=(const PreparedQuery&) = delete;
+        ~PreparedQuery() { if (q) q->finish(); }
+
+        explicit operator bool() const { return q != nullptr; }
+        QSqlQuery* operator->() const { return q; }
+        QSqlQuery& operator*() const { return *q; }
+
+    private:
+        QSqlQuery* q;
+    };
+
+    // 取当前线程连接上的预编译语句，第一次用时编译；数据库不可用时返回空
+    static PreparedQuery prepared(Statement id);
+    // 按道具列分组的语句：购买、使用各一组
+    enum class ItemStatement { Buy, Use };
+    // 某组里对应道具列的那条语句；item 不是道具列（如 Coins）时返回空
+    static PreparedQuery prepared(ItemStatement group, AssetColumn item);
+
+    static void readUser(const QSqlQuery& query, User& user);
 
 public:
     UserDao();
@@ -28,11 +91,23 @@ public:
     bool getUserById(int uid, User& user);
 
     // 更新用户数据
-    bool updateAsset(int uid, const std::string& type, int delta);
+    // 买一个道具：扣钱和加库存是同一条带余额条件的 UPDATE，金币不够（或用户不存在）时什么都不改，返回 false
+    bool purchaseItem(int uid, AssetColumn item, int cost);
+    // 用掉一个道具：库存 >= 1 才扣，不够时返回 false
+    bool consumeItem(int uid, AssetColumn item);
     bool updateMaxScore(int uid, int current_score);
     bool updateMaxLevel(int uid, int level_passed);
     std::string getNicknameFromDB(int uid);
+    // 在一个事务里提交一批写缓冲，任何一条失败都整体回滚
+    bool applyPending(const std::vector<PendingWrite>& batch);
+
+    // 排行榜：所有有分数的玩家（启动时载入内存，之后由 RankService 维护）
+    std::vector<RankEntry> getScores();
+    // 日榜/周榜快照：整张榜按名次排好后一次替换写入；读回时昵称取 users 表里的
+    bool saveRankSnapshot(const std::string& board, int period, const std::vector<RankEntry>& entries);
+    std::vector<RankEntry> loadRankSnapshot(const std::string& board, int period);
 
-    // 排行榜
-    json getLeaderboard();
+    // 后台检查点线程：各连接关闭了自动检查点，WAL 由它定期合并回主库。stop 时做最后一次截断检查点
+    static void startCheckpointer();
+    static void stopCheckpointer();
 };
\ No newline at end of file
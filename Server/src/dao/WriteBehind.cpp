@@ -0,0 +1,132 @@
+#include "WriteBehind.h"
+#include "UserCache.h"
+#include "../config/GameConfig.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// 单例实现
+WriteBehind& WriteBehind::getInstance() {
+    static WriteBehind instance;
+    return instance;
+}
+
+WriteBehind::~WriteBehind() {
+    stop();
+}
+
+PendingWrite& WriteBehind::entry(int uid) {
+    PendingWrite& w = pending[uid];
+    w.uid = uid;
+    if (pending.size() >= GameConfig::DB_WRITE_BEHIND_BATCH) pending_cv.notify_one(); // 攒够一批，不等定时
+    return w;
+}
+
+void WriteBehind::addAsset(int uid, AssetColumn column, int delta) {
+    if (uid <= 0 || delta == 0) return;
+    // 缓存和积压在同一把分片锁里改，并发的缓存加载不会漏掉或重复计入这笔
+    UserCache::getInstance().update(uid, [&](User* cached) {
+        if (cached) {
+            switch (column) {
+                case AssetColumn::Coins: cached->coins += delta; break;
+                case AssetColumn::ItemBomb: cached->item_bomb += delta; break;
+                case AssetColumn::ItemReset: cached->item_reset += delta; break;
+                case AssetColumn::ItemFreeze: cached->item_freeze += delta; break;
+            }
+        }
+        std::lock_guard<std::mutex> l(pending_mutex);
+        entry(uid).deltas[static_cast<int>(column)] += delta;
+    });
+}
+
+void WriteBehind::submitMaxScore(int uid, int score) {
+    if (uid <= 0 || score <= 0) return;
+    UserCache::getInstance().update(uid, [&](User* cached) {
+        if (cached) cached->max_score = std::max(cached->max_score, score);
+        std::lock_guard<std::mutex> l(pending_mutex);
+        PendingWrite& w = entry(uid);
+        w.max_score = std::max(w.max_score, score);
+    });
+}
+
+bool WriteBehind::flush(int uid) {
+    std::lock_guard<std::mutex> c(commit_mutex);
+    std::vector<PendingWrite> batch;
+    {
+        std::lock_guard<std::mutex> l(pending_mutex);
+        auto it = pending.find(uid);
+        if (it == pending.end()) return false;
+        batch.push_back(it->second);
+        pending.erase(it);
+    }
+    commit(batch);
+    return true;
+}
+
+// 调用方持有 commit_mutex。失败时把这批改动合并回积压队列，下一轮再试，不丢数据
+void WriteBehind::commit(std::vector<PendingWrite>& batch) {
+    if (batch.empty() || userDao.applyPending(batch)) return;
+
+    std::cerr << "Warning: write-behind commit of " << batch.size() << " user(s) failed, will retry" << std::endl;
+    std::lock_guard<std::mutex> l(pending_mutex);
+    for (const PendingWrite& w : batch) {
+        PendingWrite& p = pending[w.uid];
+        p.uid = w.uid;
+        p.max_score = std::max(p.max_score, w.max_score);
+        for (int i = 0; i < ASSET_COLUMN_COUNT; i++) p.deltas[i] += w.deltas[i];
+    }
+}
+
+void WriteBehind::start() {
+    std::lock_guard<std::mutex> l(pending_mutex);
+    if (running) return;
+    running = true;
+    worker = std::thread(&WriteBehind::run, this);
+}
+
+void WriteBehind::stop() {
+    {
+        std::lock_guard<std::mutex> l(pending_mutex);
+        running = false;
+        pending_cv.notify_one();
+    }
+    if (worker.joinable()) worker.join();
+
+    // 停止之后才进来的改动，以及最后一轮提交失败退回积压的，同步提交掉
+    std::lock_guard<std::mutex> c(commit_mutex);
+    std::vector<PendingWrite> batch;
+    {
+        std::lock_guard<std::mutex> l(pending_mutex);
+        for (auto& [uid, w] : pending) batch.push_back(w);
+        pending.clear();
+    }
+    if (!batch.empty() && !userDao.applyPending(batch)) {
+        std::cerr << "Error: lost write-behind changes of " << batch.size() << " user(s)" << std::endl;
+    }
+}
+
+void WriteBehind::run() {
+    const auto window = std::chrono::milliseconds(GameConfig::DB_WRITE_BEHIND_MS);
+    bool stopping = false;
+    while (!stopping) {
+        {
+            // 等的时候不占 commit_mutex，不挡 flush(uid)
+            std::unique_lock<std::mutex> lk(pending_mutex);
+            pending_cv.wait_for(lk, window, [this] {
+                return !running || pending.size() >= GameConfig::DB_WRITE_BEHIND_BATCH;
+            });
+            stopping = !running;
+        }
+
+        std::lock_guard<std::mutex> c(commit_mutex);
+        std::vector<PendingWrite> batch;
+        {
+            std::lock_guard<std::mutex> l(pending_mutex);
+            batch.reserve(pending.size());
+            for (auto& [uid, w] : pending) batch.push_back(w);
+            pending.clear();
+        }
+        commit(batch);
+    }
+}
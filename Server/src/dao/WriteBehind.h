@@ -0,0 +1,49 @@
+#pragma once
+
+#include "UserDao.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// 分数/资产的写缓冲：只增不减的改动（最高分、奖励金币、发放道具）先记在内存里按 uid 合并，
+// 后台线程每隔一小段时间在一个事务里批量提交。扣减类操作要先 flush 该用户，保证余额检查看到的是最新值
+class WriteBehind {
+public:
+    // 单例获取
+    static WriteBehind& getInstance();
+
+    // 禁止拷贝
+    WriteBehind(const WriteBehind&) = delete;
+    void operator=(const WriteBehind&) = delete;
+
+    // 记一笔资产增量（同一用户的多笔累加）
+    void addAsset(int uid, AssetColumn column, int delta);
+    // 记一个分数，提交时只会抬高数据库里的最高分（同一用户只保留最大的）
+    void submitMaxScore(int uid, int score);
+
+    // 立即提交该用户积压的改动，返回之前是否有积压
+    bool flush(int uid);
+
+    // 启动 / 停止后台提交线程，stop 时把剩下的全部提交
+    void start();
+    void stop();
+
+private:
+    WriteBehind() = default; // 私有构造
+    ~WriteBehind();
+
+    UserDao userDao;
+
+    std::mutex pending_mutex;
+    std::condition_variable pending_cv;
+    std::unordered_map<int, PendingWrite> pending; // uid -> 积压的改动
+    std::mutex commit_mutex; // 提交串行化：flush(uid) 返回时，后台正在提交的那批也已经落盘
+    std::thread worker;
+    bool running = false;
+
+    PendingWrite& entry(int uid);
+    void commit(std::vector<PendingWrite>& batch);
+    void run();
+};
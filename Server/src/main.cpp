@@ -2,8 +2,24 @@
 #include "crow_all.h"
 #include "controllers/AuthController.h"
 #include "controllers/GameController.h"
+#include "controllers/PushController.h"
+#include "controllers/StaticController.h"
 #include "utils/WebPage.h" 
+#include "utils/Arena.h"
+#include "utils/RateLimiter.h"
+#include "dao/WriteBehind.h"
+#include "services/RankService.h"
+#include "config/ServerConfig.h"
 #include <QCoreApplication>
+#include <cstdlib>
+#include <csignal>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <filesystem>
 
 // CORS 中间件
 struct CORSMiddleware {
@@ -16,14 +32,187 @@ struct CORSMiddleware {
     void after_handle(crow::request& req, crow::response& res, context& ctx) {
         res.add_header("Access-Control-Allow-Origin", "*");
         res.add_header("Access-Control-Allow-Methods", "POST, GET, OPTIONS");
-        res.add_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
+        res.add_header("Access-Control-Allow-Headers", "Content-Type, Authorization, If-None-Match");
+        res.add_header("Access-Control-Expose-Headers", "ETag");
     }
 };
 
+// WebSocket 升级请求：Crow 只调用全局中间件的 before_handle，之后把连接交给 WebSocket，
+// 不会再调用 after_handle（判断条件与 Crow 一致，h2 的 upgrade 头会被忽略、按普通请求处理）
+static bool isWebSocketUpgrade(const crow::request& req) {
+    return req.upgrade && req.get_header_value("upgrade").find("h2") != 0;
+}
+
+// 停机排空：统计正在处理的请求数；停机开始后拒绝开新对局，已有对局的请求照常处理
+struct DrainMiddleware {
+    struct context {};
+
+    inline static std::atomic<int> inflight{0}; // 正在处理的 HTTP 请求数（不含 WebSocket）
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx) {
+        if (isWebSocketUpgrade(req)) return; // 没有对应的 after_handle，计进来就永远减不掉
+        inflight.fetch_add(1);
+        if (!GameService::getInstance().isDraining()) return;
+        if (req.url != "/api/game/start" && req.url != "/api/pve/start" && req.url != "/api/pvp/match") return;
+
+        // 让客户端稍后重试，由负载均衡转到其他实例
+        static const std::string body = Response::error(503, "服务器即将重启，请稍后再试").dump();
+        res.code = 503;
+        res.set_header("Content-Type", "application/json");
+        res.set_header("Retry-After", "5");
+        res.write(body);
+        res.end();
+    }
+
+    void after_handle(crow::request& req, crow::response& res, context& ctx) {
+        inflight.fetch_sub(1);
+    }
+};
+
+// 限流中间件：按 IP / uid / 接口的令牌桶做准入，超限直接回 429，不进入 JSON 解析和数据库
+struct RateLimitMiddleware {
+    struct context {};
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx) {
+        if (req.method == crow::HTTPMethod::OPTIONS) return; // 预检请求不计数
+
+        int uid = RateLimiter::uidFromAuth(req.get_header_value("Authorization"));
+        int retryAfter = 1;
+        if (RateLimiter::getInstance().admit(req.url, clientAddress(req), uid, retryAfter)) return;
+
+        static const std::string body = Response::error(429, "请求过于频繁，请稍后再试").dump();
+        res.code = 429;
+        res.set_header("Content-Type", "application/json");
+        res.set_header("Retry-After", std::to_string(retryAfter));
+        res.write(body);
+        res.end();
+    }
+
+    void after_handle(crow::request& req, crow::response& res, context& ctx) {
+        // No-op
+    }
+
+    // 客户端地址。经 Unix 域套接字进来的请求没有对端 IP，只可能来自同机的反向代理，取代理转发的地址。
+    // X-Forwarded-For 前面的部分是客户端自己随便填的，只有最后一跳是代理追加的真实对端
+    static std::string clientAddress(const crow::request& req) {
+        if (!req.remote_ip_address.empty()) return req.remote_ip_address;
+        std::string ip = req.get_header_value("X-Real-IP");
+        if (ip.empty()) {
+            ip = req.get_header_value("X-Forwarded-For");
+            size_t comma = ip.rfind(',');
+            if (comma != std::string::npos) ip.erase(0, comma + 1);
+        }
+        ip.erase(0, ip.find_first_not_of(' '));
+        ip.erase(ip.find_last_not_of(' ') + 1);
+        return ip.empty() ? "local" : ip;
+    }
+};
+
+// 请求体大小限制：Crow 在调用中间件之前已经读完了请求体，这里拦下的是后续的解析和数据库操作
+struct BodyLimitMiddleware {
+    struct context {};
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx) {
+        if (req.body.size() <= ServerConfig::getInstance().max_body_bytes) return;
+
+        static const std::string body = Response::error(413, "请求体过大").dump();
+        res.code = 413;
+        res.set_header("Content-Type", "application/json");
+        res.write(body);
+        res.end();
+    }
+
+    void after_handle(crow::request& req, crow::response& res, context& ctx) {
+        // No-op
+    }
+};
+
+// 请求级内存池：处理请求期间构建的 ArenaJson 都从当前线程的 arena 分配，该线程处理下一个请求时一次性回收
+struct ArenaMiddleware {
+    struct context {};
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx) {
+        // 升级请求不会走到 after_handle，启用的 arena 会一直挂在这个线程上，WebSocket 回调也会从里面分配
+        if (isWebSocketUpgrade(req)) return;
+        Arena::begin();
+    }
+
+    void after_handle(crow::request& req, crow::response& res, context& ctx) {
+        Arena::end();
+    }
+};
+
+// 中间件栈，TCP 和 Unix 域套接字两个监听共用
+template <typename... M>
+struct MiddlewareStack {
+    using App = crow::App<M...>;
+    // App 自己只能开一个监听：TCP 和 Unix 域套接字同时开启时，另起一个共用 App 路由的 Server
+    using LocalServer = crow::Server<App, crow::UnixSocketAcceptor, crow::UnixSocketAdaptor, M...>;
+    using Middlewares = std::tuple<M...>;
+};
+using Stack = MiddlewareStack<CORSMiddleware, DrainMiddleware, RateLimitMiddleware, BodyLimitMiddleware, ArenaMiddleware>;
+
+// 上次异常退出留下的套接字文件会让 bind 失败，启动前先清掉（只删套接字，不误删普通文件）
+static void removeStaleSocket(const std::string& path) {
+    std::error_code ec;
+    if (std::filesystem::is_socket(path, ec)) std::filesystem::remove(path, ec);
+}
+
+// 收到的停机信号次数：第一次优雅停机，第二次立即退出。信号处理函数里只做原子计数
+static std::atomic<int> stopSignals{0};
+
+extern "C" void onStopSignal(int) {
+    stopSignals.fetch_add(1);
+}
+
+// 在截止时间前等待条件成立，期间再收到停机信号就放弃等待
+template <typename Pred>
+static bool waitUntil(std::chrono::steady_clock::time_point deadline, Pred done) {
+    while (!done()) {
+        if (stopSignals.load() > 1 || std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return true;
+}
+
+// 优雅停机：不再接受新对局 -> 等进行中的对局结束 -> 强制结算剩余对局并推送结果 -> 等处理中的请求完成 -> 停止服务
+static void drainAndStop(const std::function<void()>& stopListeners) {
+    using namespace std::chrono;
+    GameService& game = GameService::getInstance();
+    std::cout << "[Info] Stop signal received, shutting down gracefully (signal again to force)" << std::endl;
+
+    game.beginDrain();
+    auto deadline = steady_clock::now() + seconds(ServerConfig::getInstance().shutdown_grace_sec);
+    if (!waitUntil(deadline, [&] { return game.liveMatches() == 0; })) {
+        std::cout << "[Info] " << game.liveMatches() << " match(es) still running" << std::endl;
+    }
+
+    game.settleAll("Server Shutdown");
+    PushService::getInstance().flush(2000);
+    if (!waitUntil(steady_clock::now() + seconds(5), [] { return DrainMiddleware::inflight.load() == 0; })) {
+        std::cerr << "Warning: stopping with " << DrainMiddleware::inflight.load() << " request(s) in flight" << std::endl;
+    }
+
+    // 结算产生的奖励和分数还在写缓冲里，全部提交
+    WriteBehind::getInstance().stop();
+
+    stopListeners();
+}
+
 int main(int argc, char** argv) {
     QCoreApplication qtApp(argc, argv);
 
-    crow::App<CORSMiddleware> app;
+    // 配置文件路径：--config <path>，其次环境变量 GAME_CONFIG，默认 server.json
+    std::string configPath = "server.json";
+    if (const char* env = std::getenv("GAME_CONFIG")) configPath = env;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--config") configPath = argv[i + 1];
+    }
+    ServerConfig& config = ServerConfig::getInstance();
+    if (!config.load(configPath)) return 1;
+    config.print();
+
+    Stack::App app;
 
     // 全局 OPTIONS 路由
     CROW_ROUTE(app, "/<path>")
@@ -33,46 +222,97 @@ int main(int argc, char** argv) {
             res.end();
         });
 
-    // 读取并返回html
-    CROW_ROUTE(app, "/")
-    ([](const crow::request&, crow::response& res) {
-        std::string content = WebPage::readFile("index.html");
-
-        if (content.empty()) {
-            res.code = 404;
-            res.write("Error: static/index.html not found. Please check your CMake copy configuration.");
-        } else {
-            res.set_header("Content-Type", "text/html; charset=utf-8");
-            res.write(content);
-        }
-        res.end();
-    });
-
-    // 静态资源路由
-    CROW_ROUTE(app, "/<string>")
-    ([](const crow::request&, crow::response& res, std::string filename) {
-        std::string content = WebPage::readFile(filename);
-
-        if (content.empty()) {
-            res.code = 404;
-            res.write("File not found");
-        } else {
-            res.set_header("Content-Type", WebPage::getMimeType(filename));
-            res.write(content);
-        }
-        res.end();
-    });
-
-
     AuthController authController;  //用户操作核心逻辑
     GameController gameController;  //游戏操作核心逻辑
+    PushController pushController;  //对局实时推送
+    StaticController staticController; //静态资源
 
     // 注册业务逻辑路由
     authController.registerRoutes(app);
     gameController.registerRoutes(app);
+    pushController.registerRoutes(app);
+    staticController.registerRoutes(app);
+
+    // 静态资源一次性读进内存，之后文件变化时热更新
+    WebPage::getInstance().load(config.static_dir);
+
+    // 数据库 WAL 的后台检查点，分数/奖励的写缓冲
+    UserDao::startCheckpointer();
+    WriteBehind::getInstance().start();
+
+    // 排行榜载入内存，之后随分数上报维护；日榜/周榜由后台线程存快照
+    RankService::getInstance().load();
+    RankService::getInstance().start();
+
+    // 同时开 TCP 和 Unix 域套接字时，套接字由单独的 Server 监听；只开套接字时直接交给 App
+    std::unique_ptr<Stack::LocalServer> localServer;
+    Stack::Middlewares localMiddlewares; // 中间件都没有实例状态，另一份实例即可
+    std::mutex listenerMutex;
+    bool listenersStopped = false;
+    auto stopListeners = [&] {
+        app.stop();
+        std::lock_guard<std::mutex> l(listenerMutex);
+        listenersStopped = true;
+        if (!localServer) return;
+        // 还没跑起来就 stop 会被随后的 run() 忽略，先等它启动完成
+        localServer->wait_for_start(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+        localServer->stop();
+    };
+
+    if (!config.unix_socket.empty()) removeStaleSocket(config.unix_socket);
+
+    std::thread localThread;
+    if (config.port != 0 && !config.unix_socket.empty()) {
+        localThread = std::thread([&] {
+            // 等 TCP 监听起来再开：Server 启动时会把自己的端口写回 App，不能抢在 TCP 绑定之前
+            app.wait_for_server_start(std::chrono::seconds(10));
+            {
+                std::lock_guard<std::mutex> l(listenerMutex);
+                if (listenersStopped) return;
+                localServer.reset(new Stack::LocalServer(&app, crow::UnixSocketAcceptor::endpoint(config.unix_socket),
+                                                         std::string("Crow/") + crow::VERSION, &localMiddlewares,
+                                                         config.threads, static_cast<std::uint8_t>(config.keep_alive_sec)));
+            }
+            localServer->run();
+        });
+    }
+
+    // 停机信号自己处理（Crow 默认收到信号直接停止），由后台线程执行排空流程
+    app.signal_clear();
+    std::signal(SIGINT, onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
+    std::atomic<bool> serverStopped{false};
+    std::thread shutdownThread([&] {
+        while (!serverStopped.load()) {
+            if (stopSignals.load() > 0) {
+                drainAndStop(stopListeners);
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    });
 
     // 启动服务
-    app.port(8000).multithreaded().run();
+    app.bindaddr(config.bindaddr)
+        .port(config.port)
+        .concurrency(config.threads)
+        .timeout(static_cast<std::uint8_t>(config.keep_alive_sec))
+        .websocket_max_payload(config.max_body_bytes);
+    if (config.port == 0) app.local_socket_path(config.unix_socket); // 只监听套接字（会覆盖 bindaddr）
+    app.run();
+
+    serverStopped = true;
+    shutdownThread.join();
+    stopListeners(); // App 自己退出（如端口被占用）时也要停掉套接字监听
+    if (localThread.joinable()) localThread.join();
+    if (!config.unix_socket.empty()) removeStaleSocket(config.unix_socket);
+
+    // 服务停止后再停推送线程，避免它在单例析构后访问 GameService
+    PushService::getInstance().stop();
+    WebPage::getInstance().stop();
+    WriteBehind::getInstance().stop();
+    RankService::getInstance().stop();
+    UserDao::stopCheckpointer(); // 最后一次检查点，把 WAL 合并回主库
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+
+// 移动方向，INIT 表示只拉取初始盘面
+enum class Direction { Up, Down, Left, Right, Init };
+
+// 批量接口里的指令类型
+enum class CommandType { Move, UseItem };
+
+// 批量接口的一条指令（请求解析时已经完成类型检查）
+struct BatchCommand {
+    CommandType type = CommandType::Move; // 指令类型
+    int row = -1; // 行
+    int col = -1; // 列
+    Direction direction = Direction::Init; // 移动方向（仅 move）
+    std::string item_type; // 道具类型（仅 use_item）
+};
+
+inline bool parseDirection(const std::string& s, Direction& out) {
+    if (s == "UP") out = Direction::Up;
+    else if (s == "DOWN") out = Direction::Down;
+    else if (s == "LEFT") out = Direction::Left;
+    else if (s == "RIGHT") out = Direction::Right;
+    else if (s == "INIT") out = Direction::Init;
+    else return false;
+    return true;
+}
+
+inline bool parseCommandType(const std::string& s, CommandType& out) {
+    if (s == "move") out = CommandType::Move;
+    else if (s == "use_item") out = CommandType::UseItem;
+    else return false;
+    return true;
+}
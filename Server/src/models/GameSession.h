@@ -2,19 +2,42 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <deque>
+#include <utility>
 #include <chrono>
 #include <mutex>
 #include <memory>
+#include <atomic>
 #include "json.hpp"
 #include "../config/GameConfig.h"
 
+// 游戏模式，请求解析时就转成枚举，业务逻辑里不再比较字符串
+enum class GameMode { Level, Endless, Pve, Pvp };
+
+inline bool parseGameMode(const std::string& s, GameMode& out) {
+    if (s == "level") out = GameMode::Level;
+    else if (s == "endless") out = GameMode::Endless;
+    else if (s == "pve") out = GameMode::Pve;
+    else if (s == "pvp") out = GameMode::Pvp;
+    else return false;
+    return true;
+}
+
+// 公开盘面（地图 + 炸弹列表）序列化后的 JSON 文本，所有读者共享同一份
+struct BoardView {
+    long long version = -1; // 生成时对应的盘面版本号 (board_version)
+    std::string map_json; // 地图，如 [[1,2,...],...]
+    std::string bomb_json; // 炸弹列表，如 [{"c":3,"r":2,"timer":10}]
+};
+
 struct GameSession {
     std::string uuid; // 游戏会话的唯一标识符
     int uid = 0; // 用户ID
     std::string nickname = "Player"; // 用户昵称
-    std::string mode; // 游戏模式（例如：pvp, pve等）
+    GameMode mode = GameMode::Level; // 游戏模式
     int level = 1; // 当前关卡等级
     int current_score = 0; // 当前得分
+    int best_score = 0; // 开局时的历史最高分，用来判定本局是否破纪录
     int moves_left = -1; // 剩余移动次数
     bool is_over = false; // 游戏是否结束
     bool is_win = false; // 是否获胜
@@ -43,21 +66,38 @@ struct GameSession {
     std::vector<nlohmann::json> event_queue; // 事件队列
     std::shared_ptr<std::mutex> event_mutex; // 事件队列的互斥锁
 
+    std::atomic<long long> version{0}; // 状态版本号，盘面/分数/冻结/事件等任何可见变化都递增
+    std::atomic<long long> board_version{0}; // 盘面版本号，只在地图/冰块/炸弹变化时递增
+
+    std::shared_ptr<const BoardView> board_view; // 公开盘面序列化缓存，盘面版本号变化即失效
+    std::shared_ptr<std::mutex> view_mutex; // 盘面缓存的互斥锁
+
+    // 玩家操作串行化与移动请求去重
+    std::shared_ptr<std::mutex> op_mutex; // 同一局的移动/道具/批量操作逐个执行
+    long long last_seq = 0; // 最后一次处理的移动序号
+    // 最近 SEQ_REPLAY_WINDOW 个序号的返回结果 (序列化好的 JSON)，按序号从旧到新，重放时原样返回。
+    // 只留最后一个不够：流水线发出 N、N+1 后重试 N 也要拿到 N 的结果
+    std::deque<std::pair<long long, std::string>> seq_replies;
+
     GameSession() {
         event_mutex = std::make_shared<std::mutex>();
+        view_mutex = std::make_shared<std::mutex>();
+        op_mutex = std::make_shared<std::mutex>();
     }
 
-    GameSession(std::string id, int u, std::string nick, std::string m, int l)
+    GameSession(std::string id, int u, std::string nick, GameMode m, int l)
         : uuid(id), uid(u), nickname(nick), mode(m), level(l) {
 
         event_mutex = std::make_shared<std::mutex>();
+        view_mutex = std::make_shared<std::mutex>();
+        op_mutex = std::make_shared<std::mutex>();
         map.resize(8, std::vector<int>(8));
         ice_map.resize(8, std::vector<bool>(8, false));
 
         config = GameConfig::getLevelConfig(l);
         moves_left = config.max_moves;
 
-        if (mode == "pvp" || mode == "pve") {
+        if (mode == GameMode::Pvp || mode == GameMode::Pve) {
             is_pvp = true;
         }
 
@@ -66,5 +106,10 @@ struct GameSession {
         last_ai_move_time = start_time;
     }
 
+    // 标记状态发生了可见变化
+    void touch() { ++version; }
+    // 地图/冰块/炸弹变了：盘面缓存也要失效
+    void touchBoard() { ++board_version; ++version; }
+
     static int posKey(int r, int c) { return r * 8 + c; }
 };
\ No newline at end of file
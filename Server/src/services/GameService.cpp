@@ -1,4 +1,7 @@
 #include "GameService.h"
+#include "PushService.h"
+#include "RankService.h"
+#include "../config/ServerConfig.h"
 
 // 单例实现
 GameService& GameService::getInstance() {
@@ -6,10 +9,6 @@ GameService& GameService::getInstance() {
     return instance;
 }
 
-nlohmann::json GameService::getLeaderboard() {
-    return userDao.getLeaderboard();
-}
-
 
 // --- 游戏核心逻辑 ---
 
@@ -17,7 +16,7 @@ void GameService::generateMap(GameSession& session) {
     session.moves_left = -1; // 默认无限步
 
     // 根据关卡配置难度
-    if (session.mode == "level") {
+    if (session.mode == GameMode::Level) {
         if (session.level == 2) session.config.ice_count = 10;
         if (session.level == 3) session.config.bomb_count = 5;
         if (session.level == 4) session.config.virus_count = 3;
@@ -31,9 +30,9 @@ void GameService::generateMap(GameSession& session) {
     }
 
     // 1. 生成基础宝石矩阵，保证初始没有 3 连消除
-    static std::random_device rd; 
-    static std::mt19937 gen(rd()); 
-    static std::uniform_int_distribution<> dis(1, 5);
+    // 开局建图在全局锁之外并发进行，随机数引擎每个线程一份
+    thread_local std::mt19937 gen(std::random_device{}()); 
+    std::uniform_int_distribution<> dis(1, 5);
 
     for(int r = 0; r < 8; ++r) { 
         for(int c = 0; c < 8; ++c) { 
@@ -86,6 +85,7 @@ void GameService::generateMap(GameSession& session) {
         session.ice_map[r][c] = false; // 病毒上没冰
         session.bomb_map.erase(GameSession::posKey(r,c)); // 病毒位置没炸弹
     }
+    session.touchBoard();
 }
 
 // Match-3 检查算法
@@ -173,7 +173,7 @@ void GameService::applyElimination(GameSession& s, const std::set<Point>& m) {
     int ice_needed = 0; 
     int bomb_needed = 0;
     
-    if (s.mode == "level") {
+    if (s.mode == GameMode::Level) {
         if (s.level == 2) { 
             int cur = countIce(s); 
             if (cur < s.config.ice_count) ice_needed = s.config.ice_count - cur; 
@@ -191,8 +191,7 @@ void GameService::applyElimination(GameSession& s, const std::set<Point>& m) {
     while(refill_pool.size() < total_empty) refill_pool.push_back({false, -1});
     
     // 打乱补充池
-    static std::random_device rd; 
-    static std::mt19937 g(rd()); 
+    thread_local std::mt19937 g(std::random_device{}()); 
     std::shuffle(refill_pool.begin(), refill_pool.end(), g);
     
     int pool_idx = 0;
@@ -237,8 +236,8 @@ void GameService::applyElimination(GameSession& s, const std::set<Point>& m) {
     }
 }
 
-nlohmann::json GameService::forceSpawnViruses(GameSession& s, int count) {
-    nlohmann::json cells = nlohmann::json::array();
+ArenaJson GameService::forceSpawnViruses(GameSession& s, int count) {
+    ArenaJson cells = ArenaJson::array();
     int spawned = 0; 
     int attempts = 0;
     
@@ -262,8 +261,8 @@ nlohmann::json GameService::forceSpawnViruses(GameSession& s, int count) {
     return cells;
 }
 
-nlohmann::json GameService::spreadVirus(GameSession& s) { 
-    nlohmann::json new_virus = nlohmann::json::array(); 
+ArenaJson GameService::spreadVirus(GameSession& s) { 
+    ArenaJson new_virus = ArenaJson::array(); 
     std::vector<Point> sources; 
     
     // 找到所有现存病毒
@@ -292,13 +291,28 @@ nlohmann::json GameService::spreadVirus(GameSession& s) {
 
 // --- 会话与匹配管理 ---
 
-GameSession* GameService::createSession(int uid, const std::string& mode, int level) {
-    std::lock_guard<std::mutex> l(session_mutex);
-    std::string nick = userDao.getNicknameFromDB(uid);
+User GameService::loadProfile(int uid) {
+    User user;
+    user.uid = uid;
+    user.nickname = "Player";
+    if (uid == 0) {
+        user.nickname = "Guest";
+        return user;
+    }
+    UserCache::getInstance().getUser(uid, user);
+    return user;
+}
+
+GameSession* GameService::createSession(int uid, GameMode mode, int level) {
+    // 读资料、建图都在锁外完成，锁里只登记
+    User profile = loadProfile(uid);
     std::string id = "game-" + std::to_string(uid) + "-" + std::to_string(rand());
     
-    auto s = std::make_shared<GameSession>(id, uid, nick, mode, level);
+    auto s = std::make_shared<GameSession>(id, uid, profile.nickname, mode, level);
+    s->best_score = profile.max_score;
     generateMap(*s);
+
+    std::lock_guard<std::mutex> l(session_mutex);
     sessions[id] = s;
     return s.get(); // 返回原始指针供外部简单使用，但生命周期由 sessions 持有
 }
@@ -309,19 +323,21 @@ std::shared_ptr<GameSession> GameService::getSession(const std::string& uuid) {
     return nullptr;
 }
 
-nlohmann::json GameService::startPVE(int uid, int diff) {
-    std::lock_guard<std::mutex> l(session_mutex);
-    std::string nick = userDao.getNicknameFromDB(uid);
+ArenaJson GameService::startPVE(int uid, int diff) {
+    // 读资料、建图都在锁外完成，锁里只登记
+    User profile = loadProfile(uid);
+    std::string nick = profile.nickname;
     std::string pid = "pve-p-" + std::to_string(uid) + "-" + std::to_string(rand());
     
     // 玩家 Session
-    auto ps = std::make_shared<GameSession>(pid, uid, nick, "pve", 1);
+    auto ps = std::make_shared<GameSession>(pid, uid, nick, GameMode::Pve, 1);
+    ps->best_score = profile.max_score;
     ps->is_pvp = true; 
     generateMap(*ps);
 
     // AI Session
     std::string aid = "pve-ai-" + std::to_string(rand());
-    auto as = std::make_shared<GameSession>(aid, 0, "Bot", "pve", 1);
+    auto as = std::make_shared<GameSession>(aid, 0, "Bot", GameMode::Pve, 1);
     as->is_pvp = true; 
     as->is_ai = true; 
     as->ai_difficulty = diff; 
@@ -335,13 +351,23 @@ nlohmann::json GameService::startPVE(int uid, int diff) {
     ps->start_time = t; 
     as->start_time = t;
     
-    sessions[pid] = ps; 
-    sessions[aid] = as;
+    {
+        std::lock_guard<std::mutex> l(session_mutex);
+        sessions[pid] = ps; 
+        sessions[aid] = as;
+    }
     
     return {{"game_uuid", pid}, {"ai_uuid", aid}, {"difficulty", diff}};
 }
 
-nlohmann::json GameService::joinPVP(int uid) {
+ArenaJson GameService::joinPVP(int uid) {
+    // 先在锁外把自己的会话准备好（读资料、建图）；已经在排队时这份会被丢掉，代价只是一次缓存读和建图
+    User profile = loadProfile(uid);
+    std::string mid = "pvp-" + std::to_string(uid) + "-" + std::to_string(rand());
+    auto ms = std::make_shared<GameSession>(mid, uid, profile.nickname, GameMode::Pvp, 1);
+    ms->best_score = profile.max_score;
+    generateMap(*ms);
+
     std::lock_guard<std::mutex> l(session_mutex);
 
     // 检查自己是不是已经在排队了（防止狂点匹配）
@@ -350,11 +376,6 @@ nlohmann::json GameService::joinPVP(int uid) {
              return {{"status", "waiting"}, {"game_uuid", waiting_pvp_uuid}};
         }
     }
-    
-    std::string nick = userDao.getNicknameFromDB(uid);
-    std::string mid = "pvp-" + std::to_string(uid) + "-" + std::to_string(rand());
-    auto ms = std::make_shared<GameSession>(mid, uid, nick, "pvp", 1);
-    generateMap(*ms);
 
     if(waiting_pvp_uuid.empty() || sessions.find(waiting_pvp_uuid) == sessions.end()) {
         // 没人排队，我先进去等
@@ -369,6 +390,7 @@ nlohmann::json GameService::joinPVP(int uid) {
         // 互相关联
         ms->opponent_uuid = oid; ms->opponent_nickname = os->nickname;
         os->opponent_uuid = mid; os->opponent_nickname = ms->nickname;
+        os->touch();
 
         long long t = nowMs();
         ms->start_time = t; 
@@ -376,6 +398,9 @@ nlohmann::json GameService::joinPVP(int uid) {
         
         sessions[mid] = ms;
         waiting_pvp_uuid = ""; // 清空排队池
+
+        // 通知正在等待的一方：匹配成功
+        PushService::getInstance().notify(oid);
         
         return {
             {"status", "matched"},
@@ -410,6 +435,8 @@ void GameService::quitGame(const std::string& uuid) {
         if (sessions.count(s->opponent_uuid)) {
             auto opp = sessions[s->opponent_uuid];
             opp->opponent_quit = true;
+            opp->touch();
+            PushService::getInstance().notify(s->opponent_uuid);
         }
     }
 
@@ -417,45 +444,138 @@ void GameService::quitGame(const std::string& uuid) {
     std::cout << "[Info] Session quit: " << uuid << std::endl;
 }
 
+bool GameService::settleMatch(GameSession& s, const GameSession& o) {
+    s.is_over = true;
+
+    // 结算输赢
+    if(s.current_score > o.current_score) s.is_win = true;
+
+    // 结算奖励
+    int reward = s.current_score / GameConfig::COIN_DIVISOR_ENDLESS;
+    if(reward > 0) WriteBehind::getInstance().addAsset(s.uid, AssetColumn::Coins, reward);
+
+    // 分数走写缓冲，是否破纪录按开局时读到的最高分判断
+    bool newHighScore = false;
+    if (s.is_pvp || s.mode == GameMode::Endless) {
+        recordScore(s);
+        newHighScore = s.uid > 0 && s.current_score > s.best_score;
+        if (newHighScore) s.best_score = s.current_score;
+    }
+    s.touch();
+    return newHighScore;
+}
+
+void GameService::recordScore(const GameSession& s) {
+    WriteBehind::getInstance().submitMaxScore(s.uid, s.current_score);
+    RankService::getInstance().submit(s.uid, s.nickname, s.current_score); // 日榜/周榜不看历史纪录，每次都报
+}
+
+// --- 停机 ---
+
+void GameService::beginDrain() {
+    draining = true;
+    std::cout << "[Info] Draining: new matches are refused" << std::endl;
+}
+
+size_t GameService::liveMatches() {
+    std::lock_guard<std::mutex> l(session_mutex);
+    size_t n = 0;
+    for (const auto& [id, s] : sessions) {
+        if (s->is_ai || s->is_over || s->opponent_quit) continue;
+        if (s->mode != GameMode::Pve && s->mode != GameMode::Pvp) continue;
+        if (s->opponent_uuid.empty()) continue; // 还在排队，不算对局
+        n++;
+    }
+    return n;
+}
+
+size_t GameService::settleAll(const std::string& reason) {
+    // 先拷出快照，结算时要访问数据库，不能一直占着全局锁
+    std::vector<std::shared_ptr<GameSession>> snapshot;
+    std::string waiting;
+    {
+        std::lock_guard<std::mutex> l(session_mutex);
+        for (const auto& [id, s] : sessions) snapshot.push_back(s);
+        waiting = waiting_pvp_uuid;
+        waiting_pvp_uuid = "";
+    }
+
+    size_t settled = 0;
+    for (auto& s : snapshot) {
+        if (s->is_ai || (s->mode != GameMode::Pve && s->mode != GameMode::Pvp)) continue;
+
+        // 还在排队的人：按对手离开处理，客户端会回到大厅
+        if (s->uuid == waiting) {
+            s->opponent_quit = true;
+            s->touch();
+            PushService::getInstance().notify(s->uuid);
+            continue;
+        }
+
+        auto o = getSession(s->opponent_uuid);
+        if (!o) continue;
+        {
+            // 和正在执行的移动/道具串行，避免结算到一半的比分
+            std::lock_guard<std::mutex> op(*s->op_mutex);
+            if (s->is_over || s->opponent_quit) continue;
+            // 双方各自结算自己的奖励；AI 不领奖励，直接结束
+            settleMatch(*s, *o);
+            s->end_reason = reason;
+        }
+        if (o->is_ai) {
+            o->is_over = true;
+            o->touch();
+        }
+        settled++;
+        PushService::getInstance().notify(s->uuid);
+    }
+    std::cout << "[Info] Settled " << settled << " live match(es): " << reason << std::endl;
+    return settled;
+}
+
 // --- 道具逻辑 ---
 
-nlohmann::json GameService::buyItem(int uid, const std::string& itemType) {
-    int cost = 0; 
-    std::string dbField = "";
-    
-    if (itemType == "bomb") { cost = GameConfig::ITEM_COST_BOMB; dbField = "item_bomb"; }
-    else if (itemType == "reset") { cost = GameConfig::ITEM_COST_RESET; dbField = "item_reset"; }
-    else if (itemType == "freeze") { cost = GameConfig::ITEM_COST_FREEZE; dbField = "item_freeze"; }
-    else return {{"code", 400}, {"msg", "未知道具"}};
+ArenaJson GameService::buyItem(int uid, const std::string& itemType) {
+    AssetColumn column;
+    int cost = GameConfig::getItemCost(itemType);
+    if (cost < 0 || !parseItemColumn(itemType, column)) return {{"code", 400}, {"msg", "未知道具"}};
     
-    // 扣钱
-    if (!userDao.updateAsset(uid, "coins", -cost)) return {{"code", 400}, {"msg", "金币不足"}};
-    
-    // 加道具 (如果数据库炸了要回滚钱)
-    if (!userDao.updateAsset(uid, dbField, 1)) { 
-        userDao.updateAsset(uid, "coins", cost); 
-        return {{"code", 500}, {"msg", "数据库错误: 无法发货"}}; 
-    }
+    // 扣钱 + 发货一步完成 (先提交积压的奖励，余额检查才准)
+    WriteBehind::getInstance().flush(uid);
+    if (!userDao.purchaseItem(uid, column, cost)) return {{"code", 400}, {"msg", "金币不足"}};
     return {{"code", 200}, {"msg", "购买成功"}};
 }
 
-nlohmann::json GameService::useItem(const std::string& uuid, const std::string& itemType, int r, int c) {
+ArenaJson GameService::useItem(const std::string& uuid, const std::string& itemType, int r, int c) {
     auto session = getSession(uuid);
+    if (!session) return applyItem(nullptr, itemType, r, c);
+
+    std::lock_guard<std::mutex> lock(*session->op_mutex);
+    ArenaJson res = applyItem(session.get(), itemType, r, c);
+    if (res["code"] != 200) return res;
+
+    res["new_map"] = session->map;
+    ArenaJson bList = ArenaJson::array();
+    for(auto const&[k,v]:session->bomb_map) bList.push_back({{"r",k/8},{"c",k%8},{"timer",v}});
+    res["new_bombs"] = bList;
+    return res;
+}
+
+ArenaJson GameService::applyItem(GameSession* session, const std::string& itemType, int r, int c) {
     if (!session) return {{"code", 404}, {"msg", "Session not found"}};
     if (session->is_ai) return {{"code", 400}, {"msg", "PVE模式不可使用道具"}};
     if (!session->is_pvp) return {{"code", 400}, {"msg", "道具只能在 PVP/PVE 中使用"}};
     if (session->is_over) return {{"code", 400}, {"msg", "游戏已结束"}};
 
-    std::string dbField = "";
-    if (itemType == "bomb") dbField = "item_bomb";
-    else if (itemType == "reset") dbField = "item_reset";
-    else if (itemType == "freeze") dbField = "item_freeze";
-    else return {{"code", 400}, {"msg", "未知道具"}};
+    AssetColumn column;
+    if (!parseItemColumn(itemType, column)) return {{"code", 400}, {"msg", "未知道具"}};
+    if (itemType == "bomb" && (r < 0 || r >= 8 || c < 0 || c >= 8)) return {{"code", 400}, {"msg", "无效的炸弹位置"}};
 
     // 扣库存
-    if (!userDao.updateAsset(session->uid, dbField, -1)) return {{"code", 400}, {"msg", "道具数量不足"}};
+    WriteBehind::getInstance().flush(session->uid);
+    if (!userDao.consumeItem(session->uid, column)) return {{"code", 400}, {"msg", "道具数量不足"}};
 
-    nlohmann::json events = nlohmann::json::array(); // 记录事件发给前端播放动画
+    ArenaJson events = ArenaJson::array(); // 记录事件发给前端播放动画
 
     if (itemType == "reset") {
         // 重置整个地图
@@ -470,14 +590,13 @@ nlohmann::json GameService::useItem(const std::string& uuid, const std::string&
             if (opp && nowMs() > opp->immunity_until) {
                 opp->frozen_until = nowMs() + GameConfig::FREEZE_DURATION_MS;
                 opp->immunity_until = opp->frozen_until + 5000; // 冻结后给点保护期
+                opp->touch();
             }
         }
     }
     else if (itemType == "bomb") {
-        if (r < 0 || r >= 8 || c < 0 || c >= 8) return {{"code", 400}, {"msg", "无效的炸弹位置"}};
-
         // 1. 记录炸弹消除区域 (3x3)
-        nlohmann::json bombCoords = nlohmann::json::array();
+        ArenaJson bombCoords = ArenaJson::array();
         for (int nr = r - 1; nr <= r + 1; ++nr) {
             for (int nc = c - 1; nc <= c + 1; ++nc) {
                 if (nr >= 0 && nr < 8 && nc >= 0 && nc < 8) {
@@ -494,7 +613,7 @@ nlohmann::json GameService::useItem(const std::string& uuid, const std::string&
         std::set<Point> emptyMatches; // 空集，因为炸弹后只是填充，暂不处理消除
         applyElimination(*session, emptyMatches);
 
-        nlohmann::json cbs = nlohmann::json::array();
+        ArenaJson cbs = ArenaJson::array();
         for(auto const&[k,v]:session->bomb_map) cbs.push_back({{"r",k/8},{"c",k%8},{"timer",v}});
         events.push_back({{"type", "refill"}, {"map", session->map}, {"ice_map", session->ice_map}, {"bomb_map", cbs}});
 
@@ -507,40 +626,68 @@ nlohmann::json GameService::useItem(const std::string& uuid, const std::string&
             session->current_score += (ms.size() * 10);
 
             // 记录连锁消除
-            nlohmann::json ecs = nlohmann::json::array();
+            ArenaJson ecs = ArenaJson::array();
             for(auto p : ms) ecs.push_back({p.r, p.c});
             events.push_back({{"type", "eliminate"}, {"coords", ecs}, {"score", (int)ms.size() * 10}});
 
             applyElimination(*session, ms);
 
             // 记录连锁填充
-            cbs = nlohmann::json::array();
+            cbs = ArenaJson::array();
             for(auto const&[k,v]:session->bomb_map) cbs.push_back({{"r",k/8},{"c",k%8},{"timer",v}});
             events.push_back({{"type", "refill"}, {"map", session->map}, {"ice_map", session->ice_map}, {"bomb_map", cbs}});
         }
+        session->touchBoard();
     }
 
+    session->touch();
+
     // 把动画同步给对手（如果存在）
     if (!session->opponent_uuid.empty()) {
         auto opp = getSession(session->opponent_uuid);
         if (opp) {
-            std::lock_guard<std::mutex> lock(*opp->event_mutex);
-            for (const auto& ev : events) opp->event_queue.push_back(ev);
+            {
+                std::lock_guard<std::mutex> lock(*opp->event_mutex);
+                for (const auto& ev : events) opp->event_queue.emplace_back(ev); // 转回普通 json，队列会活过本次请求
+            }
+            opp->touch();
+            PushService::getInstance().notify(opp->uuid);
         }
     }
 
-    nlohmann::json res;
+    ArenaJson res;
     res["code"] = 200;
     res["msg"] = "Used " + itemType;
-    res["new_map"] = session->map;
     res["events"] = events;
-
-    nlohmann::json bList = nlohmann::json::array();
-    for(auto const&[k,v]:session->bomb_map) bList.push_back({{"r",k/8},{"c",k%8},{"timer",v}});
-    res["new_bombs"] = bList;
     return res;
 }
 
+// --- 批量指令 ---
+
+ArenaJson GameService::processBatch(const std::string& uuid, const std::vector<BatchCommand>& commands, JsonWriter& out) {
+    auto session = getSession(uuid);
+    if (!session) return {{"code", 404}, {"msg", "Session not found"}};
+    if (commands.size() > GameConfig::BATCH_MAX_COMMANDS) return {{"code", 400}, {"msg", "指令数量超过上限"}};
+
+    std::lock_guard<std::mutex> lock(*session->op_mutex);
+
+    // 按顺序逐条执行，每条只记录自己的结果，盘面最后统一附带一次
+    ArenaJson results = ArenaJson::array();
+    for (const auto& cmd : commands) {
+        if (cmd.type == CommandType::Move) {
+            results.push_back(applyMove(session.get(), cmd.row, cmd.col, cmd.direction));
+        } else {
+            results.push_back(applyItem(session.get(), cmd.item_type, cmd.row, cmd.col));
+        }
+    }
+
+    ArenaJson res;
+    res["code"] = 200;
+    res["results"] = results;
+    writeBoardState(*session, res, out);
+    return nullptr;
+}
+
 // --- AI 逻辑 ---
 
 std::vector<Move> GameService::getAllMoves(const std::vector<std::vector<int>>& map) { 
@@ -553,14 +700,14 @@ std::vector<Move> GameService::getAllMoves(const std::vector<std::vector<int>>&
                 auto cp = map; 
                 std::swap(cp[r][c], cp[r][c+1]); 
                 auto m = findMatches(cp); 
-                if(!m.empty()) moves.push_back({r, c, "RIGHT", (int)m.size()}); 
+                if(!m.empty()) moves.push_back({r, c, Direction::Right, (int)m.size()}); 
             } 
             // 试着向下换
             if(r < 7) { 
                 auto cp = map; 
                 std::swap(cp[r][c], cp[r+1][c]); 
                 auto m = findMatches(cp); 
-                if(!m.empty()) moves.push_back({r, c, "DOWN", (int)m.size()}); 
+                if(!m.empty()) moves.push_back({r, c, Direction::Down, (int)m.size()}); 
             } 
         }
     } 
@@ -568,6 +715,10 @@ std::vector<Move> GameService::getAllMoves(const std::vector<std::vector<int>>&
 }
 
 void GameService::updateAI(GameSession& ai) {
+    // 推送线程和轮询可能同时驱动同一个 AI，拿不到锁说明别人正在替它走
+    std::unique_lock<std::mutex> lock(*ai.op_mutex, std::try_to_lock);
+    if(!lock.owns_lock()) return;
+
     long long now = nowMs();
     if(now < ai.frozen_until) return; // AI 被冻结了
 
@@ -599,132 +750,223 @@ void GameService::updateAI(GameSession& ai) {
         bm = (ai.ai_difficulty == 2 && ms.size() > 1 && randomInt(0, 100) < 30) ? ms[1] : ms[0];
     }
     
-    processMove(ai.uuid, bm.r, bm.c, bm.dir);
+    applyMove(&ai, bm.r, bm.c, bm.dir);
     ai.last_ai_move_time = now;
 }
 
 
 // --- 核心状态轮询 ---
 
-nlohmann::json GameService::getDualState(const std::string& uuid) {
+DualState GameService::getDualState(const std::string& uuid, const std::string& knownVersion, JsonWriter& out) {
     auto s = getSession(uuid); 
-    if(!s) return {{"status", "error"}, {"msg", "Session lost"}};
+    if(!s) {
+        out.beginObject().key("msg").value("Session lost").key("status").value("error").endObject();
+        return {"error", ""};
+    }
     
     if(s->opponent_quit) { 
         s->is_over = true; 
-        return {{"status", "opponent_left"}}; 
+        out.beginObject().key("status").value("opponent_left").endObject();
+        return {"opponent_left", ""};
     }
 
-    nlohmann::json res;
     // 等人中...
-    if(s->mode == "pvp" && !s->is_ai && s->opponent_uuid.empty()) { 
-        res["status"] = "waiting"; 
-        return res; 
+    if(s->mode == GameMode::Pvp && !s->is_ai && s->opponent_uuid.empty()) { 
+        out.beginObject().key("status").value("waiting").endObject();
+        return {"waiting", ""};
     }
     
     auto o = getSession(s->opponent_uuid);
     if(!o) { 
-        res["status"] = "opponent_left"; 
         s->is_over = true; 
-        return res; 
+        out.beginObject().key("status").value("opponent_left").endObject();
+        return {"opponent_left", ""};
     }
 
     // 顺便驱动一下 AI
     if(o->is_ai && !o->is_over) updateAI(*o);
 
-    res["status"] = "playing";
-    res["my_score"] = s->current_score;
-    res["opp_nickname"] = s->opponent_nickname;
-    
     long long now = nowMs();
-    res["is_frozen"] = (now < s->frozen_until); 
-    res["freeze_time_ms"] = (now < s->frozen_until ? s->frozen_until - now : 0);
-    res["opp_score"] = o->current_score;
+
+    // 时间判定
+    long long elapsed = now - s->start_time; 
+    long long left = ServerConfig::getInstance().match_duration_sec * 1000LL - elapsed; // 一局的时长见配置
+    bool newHighScore = false;
+    
+    if(left <= 0 && !s->is_over) {
+        // HTTP 轮询和推送线程可能同时走到这里：在 op_mutex 里再判断一次，保证只结算一次，
+        // 也和正在执行的移动/道具、停机时的 settleAll 串行
+        std::lock_guard<std::mutex> op(*s->op_mutex);
+        if(!s->is_over) {
+            newHighScore = settleMatch(*s, *o);
+            o->is_over = true;
+            if(o->current_score > s->current_score) o->is_win = true;
+            o->touch();
+        }
+    }
+
+    // 双方都没有变化：只回一个版本号，省掉整张盘面的序列化
+    std::string version = dualVersion(*s, *o, now, left);
+    if(!knownVersion.empty() && knownVersion == version) {
+        out.beginObject().key("status").value("unchanged").key("version").value(version).endObject();
+        return {"unchanged", version};
+    }
+
+    // 对手盘面信息（用于显示小窗口），直接复用共享的序列化缓存
+    auto oppView = getBoardView(*o);
+
+    // 按键的字典序直接写出，与 json::dump() 的输出一致
+    out.beginObject();
+    if(s->is_over) out.key("coins_earned").value(s->current_score / GameConfig::COIN_DIVISOR_ENDLESS);
+    out.key("freeze_time_ms").value(now < s->frozen_until ? s->frozen_until - now : 0LL);
+    out.key("is_frozen").value(now < s->frozen_until);
+    out.key("is_over").value(s->is_over);
+    out.key("is_win").value(s->is_win);
+    out.key("my_score").value(s->current_score);
+    if(newHighScore) out.key("new_high_score").value(true);
+    out.key("opp_bomb_list").raw(oppView->bomb_json);
 
     // 获取并清空这一帧收到的事件（比如对手用了道具产生的动画）
+    out.key("opp_events").beginArray();
     {
         std::lock_guard<std::mutex> lock(*s->event_mutex);
-        res["opp_events"] = s->event_queue;
+        for (const auto& ev : s->event_queue) out.value(ev);
         s->event_queue.clear();
     }
+    out.endArray();
+
+    out.key("opp_is_frozen").value(now < o->frozen_until);
+    out.key("opp_map").raw(oppView->map_json);
+    out.key("opp_nickname").value(s->opponent_nickname);
+    out.key("opp_score").value(o->current_score);
+    out.key("status").value("playing");
+    out.key("time_left_sec").value(left > 0 ? left / 1000 : 0LL);
+    out.key("version").value(version);
+    out.endObject();
+
+    return {"playing", version};
+}
 
-    // 对手盘面信息（用于显示小窗口）
-    res["opp_map"] = o->map;
-    nlohmann::json obs = nlohmann::json::array(); 
-    for(auto const&[k,v] : o->bomb_map) 
-        obs.push_back({{"r", k/8}, {"c", k%8}, {"timer", v}});
-    res["opp_bomb_list"] = obs; 
-    res["opp_is_frozen"] = (now < o->frozen_until);
+std::shared_ptr<const BoardView> GameService::getBoardView(GameSession& s) {
+    std::lock_guard<std::mutex> lock(*s.view_mutex);
+    // 按盘面版本号缓存：分数、冻结、事件入队等只动 version 的变化不会让盘面重新序列化。
+    // 先取版本号再序列化：序列化期间如果盘面又变了，版本号也会跟着变，缓存自然失效
+    long long ver = s.board_version.load();
+    if(s.board_view && s.board_view->version == ver) return s.board_view;
+
+    auto view = std::make_shared<BoardView>();
+    view->version = ver;
+    JsonWriter mapOut(view->map_json);
+    mapOut.grid(s.map);
+    JsonWriter bombOut(view->bomb_json);
+    writeBombs(s.bomb_map, bombOut);
+
+    s.board_view = view;
+    return view;
+}
 
-    // 时间判定
-    long long elapsed = now - s->start_time; 
-    long long left = 60000 - elapsed; // 60秒一局
-    
-    if(left <= 0 && !s->is_over) {
-        s->is_over = true; 
-        o->is_over = true;
-        
-        // 结算输赢
-        if(s->current_score > o->current_score) s->is_win = true; 
-        else if(o->current_score > s->current_score) o->is_win = true;
-        
-        // 结算奖励
-        int reward = s->current_score / GameConfig::COIN_DIVISOR_ENDLESS;
-        if(reward > 0) userDao.updateAsset(s->uid, "coins", reward);
-        
-        if (s->is_pvp || s->mode == "endless") { 
-            if (userDao.updateMaxScore(s->uid, s->current_score)) res["new_high_score"] = true; 
-        }
-    }
-    
-    res["time_left_sec"] = (left > 0 ? left/1000 : 0); 
-    res["is_over"] = s->is_over; 
-    res["is_win"] = s->is_win;
-    if(s->is_over) res["coins_earned"] = (s->current_score / GameConfig::COIN_DIVISOR_ENDLESS);
-    
-    return res;
+std::string GameService::dualVersion(const GameSession& s, const GameSession& o, long long now, long long left) {
+    // 冻结倒计时按 100ms 取整，前端显示精度就是 0.1s
+    long long my_freeze = (now < s.frozen_until) ? (s.frozen_until - now) / 100 + 1 : 0;
+    bool opp_frozen = (now < o.frozen_until);
+    return std::to_string(s.version.load()) + "-" + std::to_string(o.version.load()) + "-" +
+           std::to_string(left > 0 ? left / 1000 : 0) + "-" + std::to_string(my_freeze) + "-" +
+           (opp_frozen ? "1" : "0");
 }
 
 // --- 处理移动 ---
 
-nlohmann::json GameService::processMove(const std::string& uuid, int row, int col, const std::string& direction) {
+void GameService::processMove(const std::string& uuid, int row, int col, Direction direction, long long seq, JsonWriter& out) {
     auto session = getSession(uuid); 
+    if (!session) {
+        out.value(applyMove(nullptr, row, col, direction));
+        return;
+    }
 
-    // 构建返回状态的 Lambda，省得每次 return 都写一遍
-    auto buildState = [&](bool valid, const std::string& msg = "") {
-        nlohmann::json res; 
+    std::lock_guard<std::mutex> lock(*session->op_mutex);
+    if (seq > 0) {
+        // 重试的请求（最近几个序号内）：不再执行，直接返回当时的结果
+        if (seq <= session->last_seq) {
+            for (const auto& [s, body] : session->seq_replies) {
+                if (s == seq) {
+                    out.raw(body);
+                    return;
+                }
+            }
+        }
+        if (seq <= session->last_seq || seq > session->last_seq + 1) {
+            out.beginObject()
+                .key("expected_seq").value(session->last_seq + 1)
+                .key("msg").value(seq < session->last_seq ? "Stale seq" : "Out of order")
+                .key("valid").value(false)
+            .endObject();
+            return;
+        }
+    }
+
+    size_t begin = out.size();
+    writeBoardState(*session, applyMove(session.get(), row, col, direction), out);
+
+    if (seq > 0) {
+        session->last_seq = seq;
+        session->seq_replies.emplace_back(seq, out.str().substr(begin));
+        if (session->seq_replies.size() > GameConfig::SEQ_REPLAY_WINDOW) session->seq_replies.pop_front();
+    }
+}
+
+// 把本次操作的结果和当前盘面/对局状态合并成一个对象写出
+void GameService::writeBoardState(const GameSession& s, const ArenaJson& result, JsonWriter& out) {
+    out.merged(result, {
+        {"game_status", [&s](JsonWriter& w) {
+            w.beginObject()
+                .key("current_score").value(s.current_score)
+                .key("is_over").value(s.is_over)
+                .key("is_win").value(s.is_win)
+                .key("moves_left").value(s.moves_left)
+                .key("reason").value(s.end_reason)
+                .key("target_score").value(s.config.target_score)
+            .endObject();
+        }},
+        {"special_layers", [&s](JsonWriter& w) {
+            w.beginObject().key("bomb_list");
+            writeBombs(s.bomb_map, w);
+            w.key("ice_map").grid(s.ice_map).endObject();
+        }},
+        {"sync_map", [&s](JsonWriter& w) { w.grid(s.map); }},
+    });
+}
+
+// 炸弹列表，如 [{"c":3,"r":2,"timer":10}]
+void GameService::writeBombs(const std::map<int, int>& bombs, JsonWriter& out) {
+    out.beginArray();
+    for(auto const&[k,v] : bombs)
+        out.beginObject().key("c").value(k%8).key("r").value(k/8).key("timer").value(v).endObject();
+    out.endArray();
+}
+
+ArenaJson GameService::applyMove(GameSession* session, int row, int col, Direction direction) {
+    // 构建返回结果的 Lambda（不含盘面，盘面由调用方统一追加），省得每次 return 都写一遍
+    auto buildState = [](bool valid, const std::string& msg = "") {
+        ArenaJson res; 
         res["valid"] = valid; 
         if(!msg.empty()) res["msg"] = msg;
-        if (!session) return res;
-        
-        res["sync_map"] = session->map; 
-        nlohmann::json bl = nlohmann::json::array();
-        for(const auto&[k,v] : session->bomb_map) 
-            bl.push_back({{"r", k/8}, {"c", k%8}, {"timer", v}});
-        
-        res["special_layers"] = {{"ice_map", session->ice_map}, {"bomb_list", bl}};
-        res["game_status"] = {
-            {"is_over", session->is_over},
-            {"is_win", session->is_win},
-            {"reason", session->end_reason},
-            {"moves_left", session->moves_left},
-            {"current_score", session->current_score},
-            {"target_score", session->config.target_score}
-        };
         return res;
     };
 
     if(!session || session->is_over) return buildState(false, "Game Over");
     if(session->is_pvp && nowMs() < session->frozen_until) return buildState(false, "FROZEN");
-    if (direction == "INIT") return buildState(true, "Init");
+    if (direction == Direction::Init) return buildState(true, "Init");
+    if(row < 0 || row >= 8 || col < 0 || col >= 8) return buildState(false, "Out");
 
     // 计算目标位置
     int tr = row, tc = col;
-    if(direction == "UP") tr--; 
-    else if(direction == "DOWN") tr++; 
-    else if(direction == "LEFT") tc--; 
-    else if(direction == "RIGHT") tc++; 
-    else return buildState(false);
+    switch (direction) {
+        case Direction::Up: tr--; break;
+        case Direction::Down: tr++; break;
+        case Direction::Left: tc--; break;
+        case Direction::Right: tc++; break;
+        default: return buildState(false);
+    }
 
     // 越界检查
     if(tr < 0 || tr >= 8 || tc < 0 || tc >= 8) return buildState(false, "Out");
@@ -747,7 +989,7 @@ nlohmann::json GameService::processMove(const std::string& uuid, int row, int co
     if(t1 != -1) session->bomb_map[k2] = t1; 
     if(t2 != -1) session->bomb_map[k1] = t2;
 
-    nlohmann::json events = nlohmann::json::array();
+    ArenaJson events = ArenaJson::array();
     events.push_back({{"type", "swap"}, {"from", {row, col}}, {"to", {tr, tc}}});
 
     bool has_elim = false; 
@@ -779,7 +1021,7 @@ nlohmann::json GameService::processMove(const std::string& uuid, int row, int co
         session->current_score += s; 
         round_score += s;
         
-        nlohmann::json ecs = nlohmann::json::array(); 
+        ArenaJson ecs = ArenaJson::array(); 
         for(auto p : ms) ecs.push_back({p.r, p.c});
         
         events.push_back({{"type", "eliminate"}, {"coords", ecs}, {"score", s}});
@@ -788,7 +1030,7 @@ nlohmann::json GameService::processMove(const std::string& uuid, int row, int co
         applyElimination(*session, ms);
         
         // 记录新的炸弹位置（因为下落了）
-        nlohmann::json cbs = nlohmann::json::array(); 
+        ArenaJson cbs = ArenaJson::array(); 
         for(auto const&[k,v] : session->bomb_map) 
             cbs.push_back({{"r", k/8}, {"c", k%8}, {"timer", v}});
             
@@ -801,6 +1043,7 @@ nlohmann::json GameService::processMove(const std::string& uuid, int row, int co
         if(opp && nowMs() > opp->immunity_until) {
             opp->frozen_until = nowMs() + 3000;
             opp->immunity_until = opp->frozen_until + 5000;
+            opp->touch();
         }
     }
 
@@ -831,7 +1074,7 @@ nlohmann::json GameService::processMove(const std::string& uuid, int row, int co
         if(!ves.empty()) events.push_back({{"type", "virus_spread"}, {"cells", ves}});
         
         // 第4关特殊逻辑：病毒不够了强制生成，增加难度
-        if (session->mode == "level" && session->level == 4) {
+        if (session->mode == GameMode::Level && session->level == 4) {
             int current_v = countViruses(*session);
             if (current_v < 2) {
                 auto new_vs = forceSpawnViruses(*session, 2);
@@ -844,16 +1087,16 @@ nlohmann::json GameService::processMove(const std::string& uuid, int row, int co
     bool new_unlock = false; 
     int coins_gained = 0;
     
-    if(!session->is_over && session->current_score >= session->config.target_score && !session->is_pvp && session->mode != "endless") {
+    if(!session->is_over && session->current_score >= session->config.target_score && !session->is_pvp && session->mode != GameMode::Endless) {
         session->is_over = true; 
         session->is_win = true; 
         session->end_reason = "Target Reached";
         
         int base_reward = GameConfig::COIN_REWARD_LEVEL_PASS; 
-        userDao.updateAsset(session->uid, "coins", base_reward); 
+        WriteBehind::getInstance().addAsset(session->uid, AssetColumn::Coins, base_reward); 
         coins_gained += base_reward;
         
-        if (session->mode == "level") { 
+        if (session->mode == GameMode::Level) { 
             if (userDao.updateMaxLevel(session->uid, session->level)) { 
                 new_unlock = true; 
                 coins_gained += 100; 
@@ -861,20 +1104,25 @@ nlohmann::json GameService::processMove(const std::string& uuid, int row, int co
         }
     }
 
-    if (session->is_pvp || session->mode == "endless") {
-        userDao.updateMaxScore(session->uid, session->current_score);
+    if (session->is_pvp || session->mode == GameMode::Endless) {
+        recordScore(*session); // 每步都报，写缓冲里只留最大值
     }
+    session->touchBoard(); // 走到这里说明交换成立，盘面一定变了
 
     // 同步事件给对手
     if (!session->opponent_uuid.empty()) {
         auto opp = getSession(session->opponent_uuid);
         if (opp) {
-            std::lock_guard<std::mutex> lock(*opp->event_mutex);
-            for (const auto& ev : events) opp->event_queue.push_back(ev);
+            {
+                std::lock_guard<std::mutex> lock(*opp->event_mutex);
+                for (const auto& ev : events) opp->event_queue.emplace_back(ev); // 转回普通 json，队列会活过本次请求
+            }
+            opp->touch();
+            PushService::getInstance().notify(opp->uuid);
         }
     }
 
-    nlohmann::json res = buildState(true);
+    ArenaJson res = buildState(true);
     res["total_score_gained"] = round_score;
     res["attack_triggered"] = (round_score > 80);
     res["events"] = events;
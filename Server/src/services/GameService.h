@@ -1,8 +1,13 @@
 #pragma once
 
 #include "../models/GameSession.h"
+#include "../models/Command.h"
 #include "../config/GameConfig.h"
 #include "../dao/UserDao.h"
+#include "../dao/WriteBehind.h"
+#include "../dao/UserCache.h"
+#include "../utils/JsonWriter.h"
+#include "../utils/Arena.h"
 
 #include <random>
 #include <map>
@@ -14,6 +19,7 @@
 #include <chrono>
 #include <memory>
 #include <string>
+#include <atomic>
 
 // 简单的坐标点结构
 struct Point {
@@ -27,10 +33,16 @@ struct Point {
 // AI 算路用的结构
 struct Move {
     int r, c;
-    std::string dir;
+    Direction dir;
     int score;
 };
 
+// 对战状态查询的结论，完整的 data 对象已经写进调用方的 JsonWriter
+struct DualState {
+    std::string status; // playing / unchanged / waiting / opponent_left / error
+    std::string version; // 状态版本标签（playing / unchanged 时有值）
+};
+
 class GameService {
 public:
     // 单例获取
@@ -42,18 +54,32 @@ public:
 
     // --- 核心业务 API ---
 
-    nlohmann::json getLeaderboard();
-    nlohmann::json startPVE(int uid, int diff);
-    nlohmann::json joinPVP(int uid);
+    ArenaJson startPVE(int uid, int diff);
+    ArenaJson joinPVP(int uid);
     bool cancelMatch(int uid);
     void quitGame(const std::string& uuid);
-    nlohmann::json getDualState(const std::string& uuid);
-    nlohmann::json processMove(const std::string& uuid, int row, int col, const std::string& direction);
-    nlohmann::json buyItem(int uid, const std::string& itemType);
-    nlohmann::json useItem(const std::string& uuid, const std::string& itemType, int r = -1, int c = -1);
-    GameSession* createSession(int uid, const std::string& mode, int level);
+    // 状态直接流式写进 out，对手盘面复用共享的序列化缓存
+    DualState getDualState(const std::string& uuid, const std::string& knownVersion, JsonWriter& out);
+    std::shared_ptr<const BoardView> getBoardView(GameSession& s);
+    // 结果直接流式写进 out。seq > 0 时按序号去重：重复序号返回缓存结果，过期或跳号的请求直接拒绝
+    void processMove(const std::string& uuid, int row, int col, Direction direction, long long seq, JsonWriter& out);
+    ArenaJson buyItem(int uid, const std::string& itemType);
+    ArenaJson useItem(const std::string& uuid, const std::string& itemType, int r = -1, int c = -1);
+    // 成功时结果写进 out 并返回 null，失败时返回 {code, msg} 且不写 out
+    ArenaJson processBatch(const std::string& uuid, const std::vector<BatchCommand>& commands, JsonWriter& out);
+    GameSession* createSession(int uid, GameMode mode, int level);
     std::shared_ptr<GameSession> getSession(const std::string& uuid);
 
+    // --- 停机 ---
+
+    // 进入停机排空：之后不再接受新对局
+    void beginDrain();
+    bool isDraining() const { return draining.load(std::memory_order_relaxed); }
+    // 还在进行中的 PVP/PVE 对局数（按真人玩家计）
+    size_t liveMatches();
+    // 按当前比分结算所有未结束的对局并推送最终状态，返回结算的数量
+    size_t settleAll(const std::string& reason);
+
 private:
     GameService() = default; // 私有构造
 
@@ -63,6 +89,7 @@ private:
     std::map<std::string, std::shared_ptr<GameSession>> sessions;
     std::mutex session_mutex;
     std::string waiting_pvp_uuid = ""; // 正在排队的那个人
+    std::atomic<bool> draining{false}; // 停机中
 
     // --- 内部辅助函数 ---
 
@@ -71,6 +98,9 @@ private:
     int randomInt(int min, int max);
     long long nowMs();
 
+    // 对战视图的版本标签（双方版本号 + 倒计时秒数 + 冻结状态）
+    std::string dualVersion(const GameSession& s, const GameSession& o, long long now, long long left);
+
     // 统计场面
     int countIce(const GameSession& s);
     int countBombs(const GameSession& s);
@@ -81,8 +111,20 @@ private:
     std::set<Point> findMatches(const std::vector<std::vector<int>>& map); 
     void handleSpecialEliminations(GameSession& s, std::set<Point>& m); 
     void applyElimination(GameSession& s, const std::set<Point>& m); 
-    nlohmann::json spreadVirus(GameSession& s); 
-    nlohmann::json forceSpawnViruses(GameSession& s, int count); 
+    ArenaJson spreadVirus(GameSession& s); 
+    ArenaJson forceSpawnViruses(GameSession& s, int count); 
+
+    // 移动/道具的核心逻辑，只返回本次操作的结果，不附带整张盘面
+    ArenaJson applyMove(GameSession* session, int row, int col, Direction direction);
+    ArenaJson applyItem(GameSession* session, const std::string& itemType, int r, int c);
+    void writeBoardState(const GameSession& s, const ArenaJson& result, JsonWriter& out);
+    // 开局时读玩家资料（昵称、历史最高分），走用户缓存
+    User loadProfile(int uid);
+    // 结算 s 这一方的对局（胜负、金币、最高分），返回是否刷新了最高分
+    bool settleMatch(GameSession& s, const GameSession& o);
+    // 上报本局当前分数：写缓冲（落库时只抬高最高分）+ 各排行榜（都在内存里）
+    void recordScore(const GameSession& s);
+    static void writeBombs(const std::map<int, int>& bombs, JsonWriter& out);
 
     // AI 逻辑
     std::vector<Move> getAllMoves(const std::vector<std::vector<int>>& map);
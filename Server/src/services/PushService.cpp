@@ -0,0 +1,133 @@
+#include "PushService.h"
+#include "GameService.h"
+#include "../utils/Response.h"
+
+#include <chrono>
+
+// 单例实现
+PushService& PushService::getInstance() {
+    static PushService instance;
+    return instance;
+}
+
+PushService::~PushService() {
+    stop();
+}
+
+void PushService::subscribe(const void* conn, const std::string& uuid, Sender sender) {
+    std::lock_guard<std::mutex> l(push_mutex);
+    if (stopped) return;
+
+    // 同一个连接重复订阅时，先从旧对局里摘掉
+    auto it = subscribers.find(conn);
+    if (it != subscribers.end()) {
+        by_uuid[it->second.uuid].erase(conn);
+        if (by_uuid[it->second.uuid].empty()) by_uuid.erase(it->second.uuid);
+    }
+
+    subscribers[conn] = {uuid, std::move(sender)};
+    by_uuid[uuid].insert(conn);
+
+    // 推送线程懒启动
+    if (!running) {
+        running = true;
+        worker = std::thread(&PushService::run, this);
+    }
+
+    // 订阅后立刻推一次完整状态
+    pushed_version.erase(uuid);
+    pending.insert(uuid);
+    push_cv.notify_one();
+}
+
+void PushService::unsubscribe(const void* conn) {
+    std::lock_guard<std::mutex> l(push_mutex);
+    auto it = subscribers.find(conn);
+    if (it == subscribers.end()) return;
+
+    by_uuid[it->second.uuid].erase(conn);
+    if (by_uuid[it->second.uuid].empty()) {
+        by_uuid.erase(it->second.uuid);
+        pushed_version.erase(it->second.uuid);
+    }
+    subscribers.erase(it);
+}
+
+void PushService::notify(const std::string& uuid) {
+    std::lock_guard<std::mutex> l(push_mutex);
+    if (!by_uuid.count(uuid)) return; // 没人订阅就走 HTTP 轮询
+    pending.insert(uuid);
+    push_cv.notify_one();
+}
+
+bool PushService::flush(int timeoutMs) {
+    std::unique_lock<std::mutex> lk(push_mutex);
+    if (!running) return true;
+    return idle_cv.wait_for(lk, std::chrono::milliseconds(timeoutMs),
+                            [this] { return !running || (pending.empty() && !pushing); });
+}
+
+void PushService::stop() {
+    {
+        std::lock_guard<std::mutex> l(push_mutex);
+        stopped = true;
+        running = false;
+        push_cv.notify_one();
+        idle_cv.notify_all();
+    }
+    if (worker.joinable()) worker.join();
+}
+
+void PushService::run() {
+    using namespace std::chrono;
+    const auto tick = milliseconds(GameConfig::PUSH_TICK_MS);
+    auto next_tick = steady_clock::now() + tick;
+
+    std::unique_lock<std::mutex> lk(push_mutex);
+    while (running) {
+        push_cv.wait_until(lk, next_tick, [this] { return !running || !pending.empty(); });
+        if (!running) break;
+
+        std::set<std::string> targets;
+        targets.swap(pending);
+
+        // 节拍到了：所有订阅中的对局都推一次（倒计时、AI 行动、超时结算都靠它驱动）
+        if (steady_clock::now() >= next_tick) {
+            for (const auto& [uuid, conns] : by_uuid) targets.insert(uuid);
+            next_tick = steady_clock::now() + tick;
+        }
+
+        // 生成状态时会回调 GameService（可能再次 notify），必须先放锁
+        pushing = true;
+        lk.unlock();
+        pushAll(targets);
+        lk.lock();
+        pushing = false;
+        idle_cv.notify_all();
+    }
+}
+
+void PushService::pushAll(const std::set<std::string>& uuids) {
+    for (const auto& uuid : uuids) {
+        std::string known;
+        {
+            std::lock_guard<std::mutex> l(push_mutex);
+            auto v = pushed_version.find(uuid);
+            if (v != pushed_version.end()) known = v->second;
+        }
+
+        // 和上次推送的版本相同就不发了（节拍推送大多走这里）
+        JsonWriter out(JsonWriter::threadBuffer());
+        Response::beginSuccess(out);
+        DualState state = GameService::getInstance().getDualState(uuid, known, out);
+        if (state.status == "unchanged") continue;
+        Response::endSuccess(out);
+        std::string payload = out.str();
+
+        std::lock_guard<std::mutex> l(push_mutex);
+        auto it = by_uuid.find(uuid);
+        if (it == by_uuid.end()) continue; // 生成期间已经断开
+        if (!state.version.empty()) pushed_version[uuid] = state.version;
+        for (const void* conn : it->second) subscribers[conn].send(payload);
+    }
+}
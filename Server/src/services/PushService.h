@@ -0,0 +1,60 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <string>
+
+// 对局实时推送服务：WebSocket 订阅者按 game_uuid 分组，
+// 对局状态有变化时立即推送，同时按固定节拍推送倒计时并驱动 AI / 超时结算
+class PushService {
+public:
+    using Sender = std::function<void(std::string)>;
+
+    // 单例获取
+    static PushService& getInstance();
+
+    // 禁止拷贝
+    PushService(const PushService&) = delete;
+    void operator=(const PushService&) = delete;
+
+    // 订阅管理 (conn 只作为连接的标识，不会被解引用)
+    void subscribe(const void* conn, const std::string& uuid, Sender sender);
+    void unsubscribe(const void* conn);
+
+    // 对局状态有变化，尽快推送给该对局的订阅者 (无订阅者时几乎零开销)
+    void notify(const std::string& uuid);
+
+    // 等待已 notify 的状态推送完成，超时返回 false (停机时发出最终结算)
+    bool flush(int timeoutMs);
+
+    // 停止推送线程 (进程退出前调用)
+    void stop();
+
+private:
+    PushService() = default; // 私有构造
+    ~PushService();
+
+    struct Subscriber {
+        std::string uuid;
+        Sender send;
+    };
+
+    std::mutex push_mutex;
+    std::condition_variable push_cv;
+    std::condition_variable idle_cv;                        // 一轮推送完成
+    std::map<const void*, Subscriber> subscribers;          // 连接 -> 订阅信息
+    std::map<std::string, std::set<const void*>> by_uuid;   // game_uuid -> 连接集合
+    std::set<std::string> pending;                          // 待推送的对局
+    std::map<std::string, std::string> pushed_version;      // game_uuid -> 上次推送的状态版本
+    std::thread worker;
+    bool running = false;
+    bool stopped = false;
+    bool pushing = false;                                   // 推送线程正在发送（已放锁）
+
+    void run();
+    void pushAll(const std::set<std::string>& uuids);
+};
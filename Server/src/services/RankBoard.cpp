@@ -0,0 +1,57 @@
+#include "RankBoard.h"
+
+#include <algorithm>
+#include <climits>
+
+void RankBoard::clear() {
+    members.clear();
+    ordered.clear();
+}
+
+int RankBoard::countAbove(int score) const {
+    // {score, INT_MIN} 排在所有该分数的人前面，比它小的就是分数更高的人
+    return static_cast<int>(ordered.countLess({score, INT_MIN}));
+}
+
+bool RankBoard::submit(int uid, const std::string& nickname, int score) {
+    auto it = members.find(uid);
+    if (it != members.end()) {
+        if (score <= it->second.score) return false;
+        ordered.erase({it->second.score, uid});
+    }
+    members[uid] = {uid, nickname, score};
+    ordered.insert({score, uid});
+    return true;
+}
+
+std::vector<RankEntry> RankBoard::range(int offset, int limit) const {
+    std::vector<RankEntry> list;
+    if (offset < 0 || offset >= static_cast<int>(ordered.size()) || limit <= 0) return list;
+
+    size_t end = std::min(ordered.size(), static_cast<size_t>(offset) + static_cast<size_t>(limit));
+    for (size_t i = static_cast<size_t>(offset); i < end; i++) list.push_back(members.at(ordered.at(i).uid));
+    return list;
+}
+
+ArenaJson RankBoard::page(int offset, int limit, int uid) const {
+    ArenaJson list = ArenaJson::array();
+    std::vector<RankEntry> entries = range(offset, limit);
+    if (!entries.empty()) {
+        int rank = countAbove(entries.front().score) + 1;
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (i > 0 && entries[i].score != entries[i - 1].score) rank = offset + static_cast<int>(i) + 1;
+            list.push_back({{"rank", rank}, {"nickname", entries[i].nickname}, {"score", entries[i].score}});
+        }
+    }
+
+    ArenaJson data;
+    data["total"] = static_cast<int>(ordered.size());
+    data["offset"] = offset;
+    data["list"] = list;
+    if (uid > 0) {
+        auto m = members.find(uid);
+        if (m == members.end()) data["me"] = nullptr; // 还没有分数，不上榜
+        else data["me"] = {{"rank", countAbove(m->second.score) + 1}, {"score", m->second.score}};
+    }
+    return data;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../dao/UserDao.h"
+#include "../utils/Arena.h"
+#include "../utils/OrderStatTree.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 一张排行榜：每个玩家一条最高分，全体按名次放在一棵顺序统计树里，
+// "比某分数高的有多少人"和"第 k 名是谁"都是 O(log n)，与同分人数、分数大小无关；
+// 同分按 uid 排，名次按"比自己高的人数 + 1"算（同分同名次）。不加锁，由 RankService 保护
+class RankBoard {
+public:
+    void clear();
+    // 记一个分数，只有刷新了该玩家在本榜的最高分才会改动，返回是否改动了
+    bool submit(int uid, const std::string& nickname, int score);
+
+    size_t size() const { return ordered.size(); }
+    // 分数严格高于 score 的人数
+    int countAbove(int score) const;
+    // 从第 offset 名（0 起）开始按名次取最多 limit 条
+    std::vector<RankEntry> range(int offset, int limit) const;
+    // 分页结果：{total, offset, list[{rank, nickname, score}], me}，uid > 0 时带 me
+    ArenaJson page(int offset, int limit, int uid) const;
+
+private:
+    // 排序键：分数高的在前，同分 uid 小的在前
+    struct RankKey {
+        int score;
+        int uid;
+        bool operator<(const RankKey& o) const {
+            return score > o.score || (score == o.score && uid < o.uid);
+        }
+    };
+
+    std::unordered_map<int, RankEntry> members; // uid -> 本榜最高分
+    OrderStatTree<RankKey> ordered; // 全体按名次排好
+};
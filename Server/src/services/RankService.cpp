@@ -0,0 +1,150 @@
+#include "RankService.h"
+#include "../config/GameConfig.h"
+#include "../utils/Response.h"
+
+#include <chrono>
+#include <ctime>
+#include <iostream>
+
+// 单例实现
+RankService& RankService::getInstance() {
+    static RankService instance;
+    return instance;
+}
+
+RankService::~RankService() {
+    stop();
+}
+
+int RankService::periodOf(const Window& w, long long now) {
+    long long day = (now + GameConfig::RANK_TZ_OFFSET_SEC) / 86400;
+    return static_cast<int>((day + w.shift) / w.days);
+}
+
+long long RankService::periodEnd(const Window& w, int period) {
+    long long endDay = static_cast<long long>(period + 1) * w.days - w.shift;
+    return endDay * 86400 - GameConfig::RANK_TZ_OFFSET_SEC;
+}
+
+void RankService::load() {
+    long long now = std::time(nullptr);
+    std::vector<RankEntry> scores = userDao.getScores();
+
+    std::lock_guard<std::mutex> l(rank_mutex);
+    all.clear();
+    for (const RankEntry& e : scores) all.submit(e.uid, e.nickname, e.score);
+    payload.reset();
+
+    for (Window& w : windows) {
+        w.period = periodOf(w, now);
+        w.board.clear();
+        w.dirty = false;
+        for (const RankEntry& e : userDao.loadRankSnapshot(w.name, w.period)) w.board.submit(e.uid, e.nickname, e.score);
+    }
+    std::cout << "[Info] Leaderboard loaded: " << all.size() << " players, "
+              << windows[0].board.size() << " today, " << windows[1].board.size() << " this week" << std::endl;
+}
+
+void RankService::roll(long long now) {
+    for (Window& w : windows) {
+        int period = periodOf(w, now);
+        if (period == w.period) continue;
+
+        if (w.board.size() > 0) expired.push_back({w.name, w.period, w.board.range(0, static_cast<int>(w.board.size()))});
+        w.period = period;
+        w.board.clear();
+        w.dirty = false;
+        save_cv.notify_one();
+    }
+}
+
+void RankService::submit(int uid, const std::string& nickname, int score) {
+    if (uid <= 0 || score <= 0) return;
+
+    std::lock_guard<std::mutex> l(rank_mutex);
+    roll(std::time(nullptr));
+    // 分数只升不降，原来在前几名的人现在也一定还在前几名，所以只看这个人进没进前几名
+    if (all.submit(uid, nickname, score) && static_cast<size_t>(all.countAbove(score)) < GameConfig::RANK_TOP_SIZE) {
+        payload.reset();
+    }
+    for (Window& w : windows) {
+        if (w.board.submit(uid, nickname, score)) w.dirty = true;
+    }
+}
+
+std::shared_ptr<const std::string> RankService::topPayload() {
+    std::lock_guard<std::mutex> l(rank_mutex);
+    if (!payload) {
+        ArenaJson list = ArenaJson::array();
+        for (const RankEntry& e : all.range(0, static_cast<int>(GameConfig::RANK_TOP_SIZE))) {
+            list.push_back({{"nickname", e.nickname}, {"score", e.score}});
+        }
+        payload = std::make_shared<const std::string>(Response::success(list).dump());
+    }
+    return payload;
+}
+
+ArenaJson RankService::page(RankWindow window, int offset, int limit, int uid) {
+    long long now = std::time(nullptr);
+    std::lock_guard<std::mutex> l(rank_mutex);
+    if (window == RankWindow::All) return all.page(offset, limit, uid);
+
+    roll(now);
+    const Window& w = windows[window == RankWindow::Daily ? 0 : 1];
+    ArenaJson data = w.board.page(offset, limit, uid);
+    data["ends_in_sec"] = periodEnd(w, w.period) - now; // 本周期还剩多久
+    return data;
+}
+
+std::vector<RankService::Snapshot> RankService::takeSnapshots() {
+    std::vector<Snapshot> out = std::move(expired);
+    expired.clear();
+    for (Window& w : windows) {
+        if (!w.dirty) continue;
+        out.push_back({w.name, w.period, w.board.range(0, static_cast<int>(w.board.size()))});
+        w.dirty = false;
+    }
+    return out;
+}
+
+void RankService::save(const std::vector<Snapshot>& snapshots) {
+    for (const Snapshot& s : snapshots) {
+        if (!userDao.saveRankSnapshot(s.board, s.period, s.entries)) {
+            std::cerr << "Warning: failed to save " << s.board << " leaderboard #" << s.period << std::endl;
+        }
+    }
+}
+
+void RankService::start() {
+    std::lock_guard<std::mutex> l(rank_mutex);
+    if (running) return;
+    running = true;
+    worker = std::thread(&RankService::run, this);
+}
+
+void RankService::stop() {
+    {
+        std::lock_guard<std::mutex> l(rank_mutex);
+        if (!running) return;
+        running = false;
+        save_cv.notify_one();
+    }
+    if (worker.joinable()) worker.join();
+}
+
+// 后台线程：有榜过期就立即落库，其余时候每隔一段时间保存有改动的当前榜；退出前再存一次
+void RankService::run() {
+    const auto interval = std::chrono::milliseconds(GameConfig::RANK_SAVE_INTERVAL_MS);
+    std::unique_lock<std::mutex> lk(rank_mutex);
+    while (true) {
+        save_cv.wait_for(lk, interval, [this] { return !running || !expired.empty(); });
+        roll(std::time(nullptr));
+        bool stopping = !running;
+
+        std::vector<Snapshot> snapshots = takeSnapshots();
+        lk.unlock();
+        save(snapshots); // 写库时不占锁，不挡分数上报
+        lk.lock();
+        if (stopping) break;
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "RankBoard.h"
+#include "../dao/UserDao.h"
+#include "../utils/Arena.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 查哪张榜：总榜（历史最高分）、日榜、周榜
+enum class RankWindow { All, Daily, Weekly };
+
+// all / daily / weekly，未知的返回 false
+inline bool parseRankWindow(const std::string& s, RankWindow& out) {
+    if (s == "all") out = RankWindow::All;
+    else if (s == "daily") out = RankWindow::Daily;
+    else if (s == "weekly") out = RankWindow::Weekly;
+    else return false;
+    return true;
+}
+
+// 排行榜：启动时从数据库载入，之后随分数上报在内存里增量维护，请求不再扫表。
+// 日榜/周榜只保留当前周期，周期一过就换新榜，过期的榜由后台线程存进快照表；
+// 当前周期的榜也会定时和停机时存一份，重启后从快照恢复
+class RankService {
+public:
+    // 单例获取
+    static RankService& getInstance();
+
+    // 禁止拷贝
+    RankService(const RankService&) = delete;
+    void operator=(const RankService&) = delete;
+
+    // 启动时载入总榜和当前周期的日榜/周榜
+    void load();
+
+    // 启动 / 停止后台保存线程，stop 时把当前周期的榜存一份
+    void start();
+    void stop();
+
+    // 上报一个分数（不一定破纪录），各榜只在刷新了该玩家本榜最高分时才改动。不碰数据库
+    void submit(int uid, const std::string& nickname, int score);
+
+    // 总榜前 RANK_TOP_SIZE 名的完整响应体，前几名变化后第一次读取时才重新序列化
+    std::shared_ptr<const std::string> topPayload();
+
+    // 从第 offset 名（0 起）开始的一页，uid > 0 时附带该玩家自己的名次
+    ArenaJson page(RankWindow window, int offset, int limit, int uid);
+
+private:
+    RankService() = default; // 私有构造
+    ~RankService();
+
+    // 一个按时间滚动的榜。周期编号 = (按 RANK_TZ_OFFSET_SEC 换算后的日序号 + shift) / days
+    struct Window {
+        const char* name; // 快照表里的 board 列
+        int days; // 周期长度（天）
+        int shift; // 周期起点的偏移：1970-01-01 是周四，周榜 +3 让每周从周一开始
+        int period = -1; // 当前周期编号
+        RankBoard board;
+        bool dirty = false; // 上次保存后有改动
+    };
+
+    // 待落库的一张榜
+    struct Snapshot {
+        std::string board;
+        int period;
+        std::vector<RankEntry> entries; // 按名次排好
+    };
+
+    UserDao userDao;
+
+    std::mutex rank_mutex;
+    RankBoard all;
+    Window windows[2] = {{"daily", 1, 0}, {"weekly", 7, 3}}; // 按 RankWindow::Daily / Weekly 的顺序
+    std::vector<Snapshot> expired; // 已经过期、还没存进快照表的榜
+    std::shared_ptr<const std::string> payload; // 为空表示需要重新序列化
+
+    std::condition_variable save_cv;
+    std::thread worker;
+    bool running = false;
+
+    static int periodOf(const Window& w, long long now);
+    static long long periodEnd(const Window& w, int period);
+    // 调用方持有 rank_mutex：周期变了的窗口换新榜，旧榜排进 expired
+    void roll(long long now);
+    // 调用方持有 rank_mutex：取出过期的榜和有改动的当前榜
+    std::vector<Snapshot> takeSnapshots();
+    void save(const std::vector<Snapshot>& snapshots);
+    void run();
+};
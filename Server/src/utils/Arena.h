@@ -0,0 +1,119 @@
+#pragma once
+#include "json.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+#include <map>
+#include <string>
+
+// 每个工作线程一个单调内存池：处理请求期间只往前分配、从不单独释放，
+// 下一个请求开始时整体回收。没有请求在处理时（推送线程、WebSocket 回调等）分配退回全局堆
+class Arena {
+public:
+    // 当前线程正在使用的 arena，未启用时为空
+    static Arena* current() { return active(); }
+
+    // 开始一个请求：清掉上一次残留的分配并启用当前线程的 arena
+    static void begin() {
+        Arena& a = threadArena();
+        a.reset();
+        active() = &a;
+    }
+
+    // 请求结束：停止从 arena 分配，但块先不回收。after_handle 在 res.end() 里执行，
+    // 这时处理函数里的 ArenaJson 局部变量往往还活着，它们析构时还要读写这些内存；
+    // 等到本线程下一次 begin() 再统一清掉
+    static void end() {
+        active() = nullptr;
+    }
+
+    // p 是否来自本线程的 arena（不管是否启用中），这样的指针不能交给全局堆释放
+    static bool ownsLocal(const void* p) { return threadArena().owns(p); }
+
+    void* allocate(size_t size, size_t align) {
+        if (!blocks.empty()) {
+            Block& b = blocks.back();
+            size_t offset = (used + align - 1) & ~(align - 1);
+            if (offset + size <= b.size) {
+                used = offset + size;
+                return b.data.get() + offset;
+            }
+        }
+        // 当前块放不下：新开一块，大小翻倍，超大的单次分配单独成块
+        size_t next = blocks.empty() ? BLOCK_SIZE : blocks.back().size * 2;
+        if (next < size + align) next = size + align;
+        blocks.push_back({std::unique_ptr<char[]>(new char[next]), next});
+        size_t offset = (reinterpret_cast<uintptr_t>(blocks.back().data.get()) % align)
+            ? align - reinterpret_cast<uintptr_t>(blocks.back().data.get()) % align : 0;
+        used = offset + size;
+        return blocks.back().data.get() + offset;
+    }
+
+    bool owns(const void* p) const {
+        const char* c = static_cast<const char*>(p);
+        for (const Block& b : blocks)
+            if (c >= b.data.get() && c < b.data.get() + b.size) return true;
+        return false;
+    }
+
+    // 只保留最后（最大）的一块给下一个请求复用，太大的块直接还给系统
+    void reset() {
+        if (blocks.size() > 1) blocks.erase(blocks.begin(), blocks.end() - 1);
+        if (!blocks.empty() && blocks.back().size > MAX_RETAINED) blocks.clear();
+        used = 0;
+    }
+
+    inline static const size_t BLOCK_SIZE = 64 * 1024; // 第一块的大小
+    inline static const size_t MAX_RETAINED = 1024 * 1024; // 请求结束后最多保留的内存
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t used = 0; // 最后一块已用的字节数
+
+    static Arena& threadArena() {
+        thread_local Arena arena;
+        return arena;
+    }
+    static Arena*& active() {
+        thread_local Arena* a = nullptr;
+        return a;
+    }
+};
+
+// 无状态分配器：当前线程启用了 arena 就从 arena 分配，否则走全局堆。
+// 用它分配的对象不能活过所在的请求（不要存进会话等长期结构里）
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (Arena* a = Arena::current()) return static_cast<T*>(a->allocate(n * sizeof(T), alignof(T)));
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        if (Arena::ownsLocal(p)) return; // 随 arena 一起回收，请求已结束（end() 之后）也一样
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>&) const noexcept { return false; }
+};
+
+// 请求处理期间使用的 json：对象/数组节点都分配在 arena 上（字符串内容仍走 std::string）。
+// 与 nlohmann::json 之间可以直接互相构造，存进会话前需要转回 nlohmann::json
+using ArenaJson = nlohmann::basic_json<std::map, std::vector, std::string, bool, std::int64_t,
+                                       std::uint64_t, double, ArenaAllocator>;
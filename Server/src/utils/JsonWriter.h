@@ -0,0 +1,174 @@
+#pragma once
+#include "json.hpp"
+#include <string>
+#include <vector>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <type_traits>
+
+// 流式 JSON 输出：直接往字符串里追加，不构建中间 DOM。
+// 输出格式与 nlohmann::json::dump() 逐字节一致（紧凑格式、键按字典序），
+// 所以对象的键需要调用方按字典序写入
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out) : out(out) {}
+
+    // 当前线程复用的输出缓冲：清空内容但保留容量，同一线程同一时刻只能有一个使用者
+    static std::string& threadBuffer() {
+        thread_local std::string buffer;
+        buffer.clear();
+        return buffer;
+    }
+
+    std::string& str() { return out; }
+    size_t size() const { return out.size(); }
+
+    JsonWriter& beginObject() { separate(); out += '{'; first = true; return *this; }
+    JsonWriter& endObject() { out += '}'; first = false; return *this; }
+    JsonWriter& beginArray() { separate(); out += '['; first = true; return *this; }
+    JsonWriter& endArray() { out += ']'; first = false; return *this; }
+
+    JsonWriter& key(const char* k) {
+        separate();
+        out += '"';
+        out += k; // 键都是代码里的常量，不需要转义
+        out += "\":";
+        first = true; // 紧跟的值前面不加逗号
+        return *this;
+    }
+
+    JsonWriter& value(bool v) { separate(); out += v ? "true" : "false"; return *this; }
+    JsonWriter& value(int v) { return integer(v); }
+    JsonWriter& value(long long v) { return integer(v); }
+    JsonWriter& value(const char* v) { separate(); escape(v, std::strlen(v)); return *this; }
+    JsonWriter& value(const std::string& v) { separate(); escape(v.data(), v.size()); return *this; }
+
+    // 其余结构（如事件）仍是 json 对象：用 nlohmann 的序列化器直接写进缓冲，不经过中间字符串
+    template <typename BasicJson, typename = std::enable_if_t<nlohmann::detail::is_basic_json<BasicJson>::value>>
+    JsonWriter& value(const BasicJson& v) {
+        separate();
+        nlohmann::detail::serializer<BasicJson> s(nlohmann::detail::output_adapter<char>(out), ' ');
+        s.dump(v, false, false, 0);
+        return *this;
+    }
+
+    // 已经是 JSON 文本的片段（如共享的盘面缓存），原样拼接
+    JsonWriter& raw(const std::string& text) { separate(); out += text; return *this; }
+
+    // 8x8 整数盘面快速路径：宝石编号都是个位数，逐字节写出
+    JsonWriter& grid(const std::vector<std::vector<int>>& g) {
+        separate();
+        out += '[';
+        for (size_t r = 0; r < g.size(); r++) {
+            if (r) out += ',';
+            out += '[';
+            for (size_t c = 0; c < g[r].size(); c++) {
+                if (c) out += ',';
+                int v = g[r][c];
+                if (v >= 0 && v <= 9) out += static_cast<char>('0' + v);
+                else appendInt(v);
+            }
+            out += ']';
+        }
+        out += ']';
+        first = false;
+        return *this;
+    }
+
+    JsonWriter& grid(const std::vector<std::vector<bool>>& g) {
+        separate();
+        out += '[';
+        for (size_t r = 0; r < g.size(); r++) {
+            if (r) out += ',';
+            out += '[';
+            for (size_t c = 0; c < g[r].size(); c++) {
+                if (c) out += ',';
+                out += g[r][c] ? "true" : "false";
+            }
+            out += ']';
+        }
+        out += ']';
+        first = false;
+        return *this;
+    }
+
+    // 额外字段：按字典序排列的 (键, 写值的回调)
+    struct Extra {
+        const char* key;
+        std::function<void(JsonWriter&)> write;
+    };
+
+    // 把 json 对象和额外字段合并成一个对象写出，保持整体键序与 dump() 一致
+    template <typename BasicJson>
+    JsonWriter& merged(const BasicJson& obj, std::initializer_list<Extra> extra) {
+        beginObject();
+        // obj 只能是对象或 null（null 的 begin() == end()）
+        auto it = obj.begin(), itEnd = obj.end();
+        const Extra* e = extra.begin();
+        while (it != itEnd || e != extra.end()) {
+            int cmp = (it == itEnd) ? 1 : (e == extra.end()) ? -1 : it.key().compare(e->key);
+            if (cmp < 0) {
+                key(it.key().c_str()).value(it.value());
+                ++it;
+            } else {
+                if (cmp == 0) ++it; // 同名时以额外字段为准
+                key(e->key);
+                e->write(*this);
+                ++e;
+            }
+        }
+        return endObject();
+    }
+
+private:
+    std::string& out;
+    bool first = true; // 当前容器里还没有写过元素
+
+    void separate() {
+        if (!first) out += ',';
+        first = false;
+    }
+
+    template <typename T>
+    JsonWriter& integer(T v) {
+        separate();
+        appendInt(v);
+        return *this;
+    }
+
+    template <typename T>
+    void appendInt(T v) {
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), v);
+        out.append(buf, res.ptr);
+    }
+
+    // 与 nlohmann 的转义规则一致：引号、反斜杠、常见控制字符用短形式，其余控制字符用 \u00xx
+    void escape(const char* s, size_t n) {
+        out += '"';
+        for (size_t i = 0; i < n; i++) {
+            unsigned char ch = static_cast<unsigned char>(s[i]);
+            switch (ch) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\b': out += "\\b"; break;
+                case '\f': out += "\\f"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (ch < 0x20) {
+                        static const char hex[] = "0123456789abcdef";
+                        out += "\\u00";
+                        out += hex[ch >> 4];
+                        out += hex[ch & 0xF];
+                    } else {
+                        out += static_cast<char>(ch);
+                    }
+            }
+        }
+        out += '"';
+    }
+};
@@ -0,0 +1,149 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+// 顺序统计树（按子树大小增强的 treap）：插入、删除、"比 key 小的有几个"、"第 k 个是谁"都是 O(log n)。
+// Key 需要 operator<，不允许重复。节点放在一个数组里按下标引用，删掉的节点复用，不逐个 new/delete。
+// 不加锁，由调用方保护
+template <typename Key>
+class OrderStatTree {
+public:
+    OrderStatTree() { clear(); }
+
+    void clear() {
+        nodes.assign(1, Node{}); // 下标 0 是空节点，size 恒为 0
+        freeList.clear();
+        root = 0;
+    }
+
+    size_t size() const { return static_cast<size_t>(nodes[root].size); }
+
+    // 插入 key，调用方保证不重复
+    void insert(const Key& key) {
+        int l, r;
+        split(root, key, l, r);
+        root = merge(merge(l, newNode(key)), r);
+    }
+
+    // 删除 key，不存在时返回 false
+    bool erase(const Key& key) {
+        int l, r, m, rest;
+        split(root, key, l, r); // l < key <= r
+        splitFirst(r, 1, m, rest);
+        bool found = m != 0 && !(key < nodes[m].key);
+        if (found) {
+            freeList.push_back(m);
+            root = merge(l, rest);
+        } else {
+            root = merge(l, merge(m, rest));
+        }
+        return found;
+    }
+
+    // 比 key 小的元素个数（即 key 按顺序应在的下标）
+    size_t countLess(const Key& key) const {
+        size_t n = 0;
+        for (int t = root; t != 0;) {
+            if (nodes[t].key < key) {
+                n += static_cast<size_t>(nodes[nodes[t].left].size) + 1;
+                t = nodes[t].right;
+            } else {
+                t = nodes[t].left;
+            }
+        }
+        return n;
+    }
+
+    // 第 k 个元素（0 起），调用方保证 k < size()
+    const Key& at(size_t k) const {
+        int t = root;
+        while (true) {
+            size_t leftSize = static_cast<size_t>(nodes[nodes[t].left].size);
+            if (k < leftSize) {
+                t = nodes[t].left;
+            } else if (k == leftSize) {
+                return nodes[t].key;
+            } else {
+                k -= leftSize + 1;
+                t = nodes[t].right;
+            }
+        }
+    }
+
+private:
+    struct Node {
+        Key key{};
+        uint32_t priority = 0;
+        int left = 0, right = 0;
+        int size = 0;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<int> freeList; // 已删除、可复用的节点下标
+    int root = 0;
+    std::mt19937 rng{0x5eed};
+
+    int newNode(const Key& key) {
+        int i;
+        if (!freeList.empty()) {
+            i = freeList.back();
+            freeList.pop_back();
+        } else {
+            i = static_cast<int>(nodes.size());
+            nodes.emplace_back();
+        }
+        nodes[i] = Node{key, static_cast<uint32_t>(rng()), 0, 0, 1};
+        return i;
+    }
+
+    void update(int t) {
+        nodes[t].size = nodes[nodes[t].left].size + nodes[nodes[t].right].size + 1;
+    }
+
+    // 按 key 拆开：l 里都 < key，r 里都 >= key
+    void split(int t, const Key& key, int& l, int& r) {
+        if (t == 0) {
+            l = r = 0;
+            return;
+        }
+        if (nodes[t].key < key) {
+            split(nodes[t].right, key, nodes[t].right, r);
+            l = t;
+        } else {
+            split(nodes[t].left, key, l, nodes[t].left);
+            r = t;
+        }
+        update(t);
+    }
+
+    // 按个数拆开：l 是前 k 个
+    void splitFirst(int t, int k, int& l, int& r) {
+        if (t == 0) {
+            l = r = 0;
+            return;
+        }
+        if (nodes[nodes[t].left].size < k) {
+            splitFirst(nodes[t].right, k - nodes[nodes[t].left].size - 1, nodes[t].right, r);
+            l = t;
+        } else {
+            splitFirst(nodes[t].left, k, l, nodes[t].left);
+            r = t;
+        }
+        update(t);
+    }
+
+    // l 里的元素都小于 r 里的
+    int merge(int l, int r) {
+        if (l == 0 || r == 0) return l ? l : r;
+        if (nodes[l].priority > nodes[r].priority) {
+            nodes[l].right = merge(nodes[l].right, r);
+            update(l);
+            return l;
+        }
+        nodes[r].left = merge(l, nodes[r].left);
+        update(r);
+        return r;
+    }
+};
@@ -0,0 +1,106 @@
+#include "RateLimiter.h"
+
+#include <chrono>
+#include <algorithm>
+
+namespace {
+
+// FNV-1a：把桶的种类和标识拼成一个 64 位键
+uint64_t bucketKey(char kind, const std::string& a, const std::string& b = "") {
+    uint64_t h = 1469598103934665603ULL;
+    auto mix = [&h](unsigned char ch) {
+        h ^= ch;
+        h *= 1099511628211ULL;
+    };
+    mix(static_cast<unsigned char>(kind));
+    for (unsigned char ch : a) mix(ch);
+    mix(0);
+    for (unsigned char ch : b) mix(ch);
+    return h ? h : 1; // 0 留给空桶
+}
+
+} // namespace
+
+// 单例实现
+RateLimiter& RateLimiter::getInstance() {
+    static RateLimiter instance;
+    return instance;
+}
+
+RateLimiter::RateLimiter() : slots(new Slot[SLOT_COUNT]) {}
+
+bool RateLimiter::admit(const std::string& route, const std::string& ip, int uid, int& retryAfterSec) {
+    long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    long long waitNs = 0;
+    // uid 来自没有校验过的 token。登录/注册接口本来就没有登录态，客户端换一个假 token 就是一个新桶，
+    // 所以这些接口只按地址计，否则撞库限额形同虚设
+    static const std::string authPrefix = "/api/auth/";
+    bool anonymous = route.compare(0, authPrefix.size(), authPrefix) == 0;
+    std::string who = uid > 0 && !anonymous ? std::to_string(uid) : ip;
+
+    bool ok = check(bucketKey('i', ip), GameConfig::RATE_PER_IP, now, waitNs);
+    if (ok && uid > 0) ok = check(bucketKey('u', who), GameConfig::RATE_PER_UID, now, waitNs);
+    if (ok) {
+        for (const auto& limit : GameConfig::RATE_PER_ROUTE) {
+            if (route == limit.route) {
+                ok = check(bucketKey('r', route, who), limit, now, waitNs);
+                break;
+            }
+        }
+    }
+
+    if (!ok) retryAfterSec = static_cast<int>(std::max(1LL, (waitNs + 999999999LL) / 1000000000LL));
+    return ok;
+}
+
+int RateLimiter::uidFromAuth(const std::string& header) {
+    static const std::string prefix = "Bearer mock-token-";
+    if (header.compare(0, prefix.size(), prefix) != 0) return 0;
+    long long uid = 0;
+    for (size_t i = prefix.size(); i < header.size(); i++) {
+        char ch = header[i];
+        if (ch < '0' || ch > '9' || uid > 100000000) return 0;
+        uid = uid * 10 + (ch - '0');
+    }
+    return static_cast<int>(uid);
+}
+
+bool RateLimiter::check(uint64_t key, const RateLimit& limit, long long now, long long& waitNs) {
+    return take(find(key, now), limit, now, waitNs);
+}
+
+RateLimiter::Slot& RateLimiter::find(uint64_t key, long long now) {
+    size_t base = static_cast<size_t>(key) & (SLOT_COUNT - 1);
+    for (int i = 0; i < MAX_PROBES; i++) {
+        Slot& s = slots[(base + i) & (SLOT_COUNT - 1)];
+        uint64_t k = s.key.load(std::memory_order_acquire);
+        if (k == key) return s;
+
+        // 空桶，或者早已回满的旧桶（状态和新桶一样），可以直接接管
+        if (k == 0 || s.tat.load(std::memory_order_relaxed) <= now) {
+            if (s.key.compare_exchange_strong(k, key, std::memory_order_acq_rel)) {
+                s.tat.store(0, std::memory_order_relaxed);
+                return s;
+            }
+            if (k == key) return s; // 别的线程刚为同一个键占了这个桶
+        }
+    }
+    // 探测范围内都被占满：和别的键共用一个桶，只会更严格，不会放过
+    return slots[base];
+}
+
+bool RateLimiter::take(Slot& slot, const RateLimit& limit, long long now, long long& waitNs) {
+    long long interval = static_cast<long long>(1e9 / limit.rate); // 补充一个令牌需要的时间
+    long long capacity = interval * limit.burst; // 桶满时最多可以"预支"的时间
+
+    long long tat = slot.tat.load(std::memory_order_relaxed);
+    while (true) {
+        long long next = std::max(tat, now) + interval;
+        if (next - now > capacity) {
+            waitNs = next - now - capacity;
+            return false;
+        }
+        if (slot.tat.compare_exchange_weak(tat, next, std::memory_order_relaxed)) return true;
+    }
+}
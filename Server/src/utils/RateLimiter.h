@@ -0,0 +1,43 @@
+#pragma once
+#include "../config/GameConfig.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// 令牌桶限流：每个桶只用一个原子变量记录"理论到达时间"（GCRA 形式的令牌桶），
+// 取令牌是一次 CAS；所有桶放在固定大小的开放寻址哈希表里，整个准入过程不加锁
+class RateLimiter {
+public:
+    // 单例获取
+    static RateLimiter& getInstance();
+
+    // 禁止拷贝
+    RateLimiter(const RateLimiter&) = delete;
+    void operator=(const RateLimiter&) = delete;
+
+    // 检查一次请求：依次过 IP、uid、接口三个桶，任何一个超限就拒绝，
+    // 并给出建议的重试等待秒数。uid 为 0 表示未登录；/api/auth/* 的接口桶只按 IP 计
+    bool admit(const std::string& route, const std::string& ip, int uid, int& retryAfterSec);
+
+    // 从 "Bearer mock-token-<uid>" 里取出 uid，格式不对时返回 0
+    static int uidFromAuth(const std::string& header);
+
+private:
+    RateLimiter();
+
+    struct Slot {
+        std::atomic<uint64_t> key{0}; // 桶的标识（哈希），0 表示空
+        std::atomic<long long> tat{0}; // 理论到达时间（纳秒），不晚于当前时间说明桶是满的
+    };
+
+    inline static const size_t SLOT_COUNT = 1 << 14; // 表大小（2 的幂）
+    inline static const int MAX_PROBES = 8; // 线性探测的最大步数
+
+    std::unique_ptr<Slot[]> slots;
+
+    Slot& find(uint64_t key, long long now);
+    bool take(Slot& slot, const RateLimit& limit, long long now, long long& waitNs);
+    bool check(uint64_t key, const RateLimit& limit, long long now, long long& waitNs);
+};
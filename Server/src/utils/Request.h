@@ -0,0 +1,378 @@
+#pragma once
+#include "json.hpp"
+#include "../models/GameSession.h"
+#include "../models/Command.h"
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <limits>
+
+// 请求体解码：每个接口一个请求结构体，按字段表用 SAX 方式把 JSON 直接写进类型化字段，
+// 不构建 DOM。语法错误、缺字段、类型不对、枚举值非法都转成 DecodeError，由控制器返回 400
+
+// 解码失败的原因
+struct DecodeError {
+    std::string field; // 出错的字段（如 row、commands[2].direction），语法错误时为空
+    std::string msg; // 给前端看的说明
+};
+
+// 一个字段绑定：JSON 键名 -> 目标变量
+struct Field {
+    enum class Kind { Int, Int64, String, OptString, Mode, Dir, Command, List };
+
+    const char* name;
+    Kind kind;
+    void* target;
+    bool required = false;
+    // List：向目标数组追加一个元素并返回它的字段表
+    std::vector<Field> (*append)(void* list) = nullptr;
+    // Int / Int64：允许的取值范围（Int 还受 int 本身的范围限制）
+    long long min = std::numeric_limits<long long>::min();
+    long long max = std::numeric_limits<long long>::max();
+};
+
+inline Field field(const char* name, int& v, bool required = false) { return {name, Field::Kind::Int, &v, required}; }
+// 带取值范围的整数字段，超出 [min, max] 时按"超出范围"拒绝
+inline Field field(const char* name, int& v, int min, int max, bool required = false) {
+    return {name, Field::Kind::Int, &v, required, nullptr, min, max};
+}
+inline Field field(const char* name, long long& v, bool required = false) { return {name, Field::Kind::Int64, &v, required}; }
+inline Field field(const char* name, long long& v, long long min, long long max, bool required = false) {
+    return {name, Field::Kind::Int64, &v, required, nullptr, min, max};
+}
+inline Field field(const char* name, std::string& v, bool required = false) { return {name, Field::Kind::String, &v, required}; }
+inline Field field(const char* name, std::optional<std::string>& v) { return {name, Field::Kind::OptString, &v}; }
+inline Field field(const char* name, GameMode& v, bool required = false) { return {name, Field::Kind::Mode, &v, required}; }
+inline Field field(const char* name, Direction& v, bool required = false) { return {name, Field::Kind::Dir, &v, required}; }
+inline Field field(const char* name, CommandType& v, bool required = false) { return {name, Field::Kind::Command, &v, required}; }
+
+// --- 各接口的请求结构 (默认值即字段缺省时的取值) ---
+
+struct LoginRequest {
+    std::string account;
+    std::string password;
+};
+
+struct RegisterRequest {
+    std::string account;
+    std::string password;
+    std::string nickname = "NewPlayer";
+};
+
+// 只带 uid 的请求：/api/user/sync、/api/pvp/match、/api/pvp/cancel
+struct UidRequest {
+    int uid = 0;
+};
+
+struct StartRequest {
+    GameMode mode = GameMode::Level;
+    int level = 1;
+    int uid = 0;
+};
+
+struct MoveRequest {
+    std::string game_uuid;
+    int row = 0;
+    int col = 0;
+    Direction direction = Direction::Init;
+    long long seq = 0; // 可选，同一局内从 1 开始单调递增的请求序号；0 表示没带
+};
+
+struct BatchRequest {
+    std::string game_uuid;
+    std::vector<BatchCommand> commands;
+};
+
+struct PveStartRequest {
+    int uid = 0;
+    int difficulty = 1;
+};
+
+struct StatusRequest {
+    std::string game_uuid;
+    std::optional<std::string> version; // 上次拿到的状态版本，没带时为空
+};
+
+struct BuyRequest {
+    int uid = 0;
+    std::string item_type;
+};
+
+struct UseItemRequest {
+    std::string game_uuid;
+    std::string item_type;
+    int row = -1;
+    int col = -1;
+};
+
+// /api/game/quit 和 WebSocket 订阅消息
+struct GameRequest {
+    std::string game_uuid;
+};
+
+inline std::vector<Field> fieldsOf(LoginRequest& r) {
+    return {field("account", r.account, true), field("password", r.password, true)};
+}
+inline std::vector<Field> fieldsOf(RegisterRequest& r) {
+    return {field("account", r.account, true), field("password", r.password, true), field("nickname", r.nickname)};
+}
+inline std::vector<Field> fieldsOf(UidRequest& r) {
+    return {field("uid", r.uid)};
+}
+inline std::vector<Field> fieldsOf(StartRequest& r) {
+    return {field("mode", r.mode), field("level", r.level), field("uid", r.uid)};
+}
+inline std::vector<Field> fieldsOf(MoveRequest& r) {
+    // INIT 只拉盘面，前端传 -1
+    return {field("game_uuid", r.game_uuid, true), field("row", r.row, -1, 7, true), field("col", r.col, -1, 7, true),
+            field("direction", r.direction, true),
+            field("seq", r.seq, 1, std::numeric_limits<long long>::max())};
+}
+inline std::vector<Field> fieldsOf(BatchCommand& r) {
+    return {field("type", r.type, true), field("row", r.row, -1, 7), field("col", r.col, -1, 7),
+            field("direction", r.direction), field("item_type", r.item_type)};
+}
+inline std::vector<Field> fieldsOf(PveStartRequest& r) {
+    return {field("uid", r.uid), field("difficulty", r.difficulty)};
+}
+inline std::vector<Field> fieldsOf(StatusRequest& r) {
+    return {field("game_uuid", r.game_uuid, true), field("version", r.version)};
+}
+inline std::vector<Field> fieldsOf(BuyRequest& r) {
+    return {field("uid", r.uid), field("item_type", r.item_type, true)};
+}
+inline std::vector<Field> fieldsOf(UseItemRequest& r) {
+    return {field("game_uuid", r.game_uuid, true), field("item_type", r.item_type, true),
+            field("row", r.row, -1, 7), field("col", r.col, -1, 7)};
+}
+inline std::vector<Field> fieldsOf(GameRequest& r) {
+    return {field("game_uuid", r.game_uuid)};
+}
+
+// 数组字段：元素类型需要有对应的 fieldsOf
+template <typename T>
+Field field(const char* name, std::vector<T>& v, bool required = false) {
+    Field f{name, Field::Kind::List, &v, required};
+    f.append = [](void* list) {
+        auto& vec = *static_cast<std::vector<T>*>(list);
+        vec.emplace_back();
+        return fieldsOf(vec.back());
+    };
+    return f;
+}
+
+inline std::vector<Field> fieldsOf(BatchRequest& r) {
+    return {field("game_uuid", r.game_uuid, true), field("commands", r.commands)};
+}
+
+// SAX 处理器：只认识字段表里的键，未知键连同其子树整体跳过；null 视为没传
+class RequestDecoder {
+public:
+    using number_integer_t = nlohmann::json::number_integer_t;
+    using number_unsigned_t = nlohmann::json::number_unsigned_t;
+    using number_float_t = nlohmann::json::number_float_t;
+    using string_t = nlohmann::json::string_t;
+    using binary_t = nlohmann::json::binary_t;
+
+    explicit RequestDecoder(std::vector<Field> fields) : root(std::move(fields)) {}
+
+    std::optional<DecodeError> decode(const std::string& body) {
+        if (!nlohmann::json::sax_parse(body, this) && !error) error = DecodeError{"", "请求体不是合法的 JSON"};
+        return error;
+    }
+
+    // --- SAX 回调 ---
+
+    bool null() {
+        const Field* f = nullptr;
+        if (!scalar(f)) return false;
+        if (f) frames.back().current = nullptr; // 等同于没传
+        return true;
+    }
+
+    bool boolean(bool) { return mismatch(); }
+    bool binary(binary_t&) { return mismatch(); }
+    bool number_float(number_float_t, const string_t&) { return mismatch("必须是整数"); }
+
+    bool number_integer(number_integer_t v) { return integer(v, true); }
+    bool number_unsigned(number_unsigned_t v) {
+        bool inRange = v <= static_cast<number_unsigned_t>(std::numeric_limits<long long>::max());
+        return integer(static_cast<long long>(v), inRange);
+    }
+
+    bool string(string_t& v) {
+        const Field* f = nullptr;
+        if (!scalar(f)) return false;
+        if (!f) return true;
+        switch (f->kind) {
+            case Field::Kind::String: *static_cast<std::string*>(f->target) = std::move(v); break;
+            case Field::Kind::OptString: *static_cast<std::optional<std::string>*>(f->target) = std::move(v); break;
+            case Field::Kind::Mode: if (!parseGameMode(v, *static_cast<GameMode*>(f->target))) return fail("取值非法"); break;
+            case Field::Kind::Dir: if (!parseDirection(v, *static_cast<Direction*>(f->target))) return fail("取值非法"); break;
+            case Field::Kind::Command: if (!parseCommandType(v, *static_cast<CommandType*>(f->target))) return fail("取值非法"); break;
+            default: return fail("类型错误");
+        }
+        return done();
+    }
+
+    bool start_object(std::size_t) {
+        if (skip > 0) return ++skip, true;
+        if (frames.empty()) {
+            // 请求体本身
+            frames.push_back({root, std::vector<bool>(root.size()), nullptr, "", nullptr, 0});
+            return true;
+        }
+        Frame& top = frames.back();
+        if (top.list) {
+            // 数组元素：追加一个元素，进入它的字段表
+            std::string path = top.path + "[" + std::to_string(top.index++) + "]";
+            auto fields = top.list->append(top.list->target);
+            std::vector<bool> seen(fields.size());
+            frames.push_back({std::move(fields), std::move(seen), nullptr, std::move(path), nullptr, 0});
+            return true;
+        }
+        if (!top.current) return ++skip, true; // 未知字段
+        return fail("类型错误");
+    }
+
+    bool key(string_t& k) {
+        if (skip > 0) return true;
+        Frame& top = frames.back();
+        top.current = nullptr;
+        for (const Field& f : top.fields) {
+            if (k == f.name) {
+                top.current = &f;
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool end_object() {
+        if (skip > 0) return --skip, true;
+        const Frame& top = frames.back();
+        for (size_t i = 0; i < top.fields.size(); i++) {
+            if (top.fields[i].required && !top.seen[i]) {
+                error = DecodeError{pathOf(top, top.fields[i]), std::string("缺少字段 ") + pathOf(top, top.fields[i])};
+                return false;
+            }
+        }
+        frames.pop_back();
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        if (skip > 0) return ++skip, true;
+        if (frames.empty()) return fail("请求体必须是对象");
+        Frame& top = frames.back();
+        if (top.list) return fail("类型错误"); // 数组里只允许对象
+        if (!top.current) return ++skip, true; // 未知字段
+        if (top.current->kind != Field::Kind::List) return fail("类型错误");
+        frames.push_back({{}, {}, nullptr, pathOf(top, *top.current), top.current, 0});
+        return true;
+    }
+
+    bool end_array() {
+        if (skip > 0) return --skip, true;
+        frames.pop_back();
+        return done();
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) {
+        if (!error) error = DecodeError{"", "请求体不是合法的 JSON"};
+        return false;
+    }
+
+private:
+    struct Frame {
+        std::vector<Field> fields; // 对象的字段表
+        std::vector<bool> seen; // 对应字段是否出现过
+        const Field* current = nullptr; // 当前键对应的字段，未知键为空
+        std::string path; // 对象在请求里的路径，用于错误信息
+        const Field* list = nullptr; // 非空表示这是一个数组帧
+        size_t index = 0; // 数组帧已处理的元素个数
+    };
+
+    std::vector<Field> root;
+    std::vector<Frame> frames;
+    std::optional<DecodeError> error;
+    int skip = 0; // 正在跳过的未知容器深度
+
+    static std::string pathOf(const Frame& frame, const Field& f) {
+        return frame.path.empty() ? f.name : frame.path + "." + f.name;
+    }
+
+    // 标量值开始：f 为空表示该值属于未知字段或正在跳过，直接忽略
+    bool scalar(const Field*& f) {
+        f = nullptr;
+        if (skip > 0) return true;
+        if (frames.empty()) return fail("请求体必须是对象");
+        if (frames.back().list) return fail("类型错误"); // 数组里只允许对象
+        f = frames.back().current;
+        return true;
+    }
+
+    bool mismatch(const char* why = "类型错误") {
+        const Field* f = nullptr;
+        if (!scalar(f)) return false;
+        return f ? fail(why) : true;
+    }
+
+    bool integer(long long v, bool inRange) {
+        const Field* f = nullptr;
+        if (!scalar(f)) return false;
+        if (!f) return true;
+        if (f->kind != Field::Kind::Int && f->kind != Field::Kind::Int64) return fail("类型错误");
+        if (!inRange || v < f->min || v > f->max) return fail("超出范围");
+        if (f->kind == Field::Kind::Int64) {
+            *static_cast<long long*>(f->target) = v;
+        } else {
+            if (v < std::numeric_limits<int>::min() || v > std::numeric_limits<int>::max()) return fail("超出范围");
+            *static_cast<int*>(f->target) = static_cast<int>(v);
+        }
+        return done();
+    }
+
+    // 当前字段的值处理完，标记已出现
+    bool done() {
+        Frame& top = frames.back();
+        if (top.current) top.seen[top.current - top.fields.data()] = true;
+        top.current = nullptr;
+        return true;
+    }
+
+    bool fail(const char* why) {
+        std::string name;
+        if (!frames.empty()) {
+            const Frame& top = frames.back();
+            if (top.current) name = pathOf(top, *top.current);
+            else if (top.list) name = top.path;
+        }
+        error = DecodeError{name, name.empty() ? why : name + " " + why};
+        return false;
+    }
+};
+
+// 解码之后的跨字段检查，默认没有
+template <typename R>
+std::optional<DecodeError> validate(const R&) { return std::nullopt; }
+
+// move 指令必须带真实坐标，-1 只留给不需要位置的道具（use_item 只有炸弹需要，由服务层检查）
+inline std::optional<DecodeError> validate(const BatchRequest& r) {
+    for (size_t i = 0; i < r.commands.size(); i++) {
+        const BatchCommand& cmd = r.commands[i];
+        if (cmd.type != CommandType::Move) continue;
+        std::string path = "commands[" + std::to_string(i) + "]";
+        if (cmd.row < 0) return DecodeError{path + ".row", "move 指令缺少 " + path + ".row 或取值不在 0~7"};
+        if (cmd.col < 0) return DecodeError{path + ".col", "move 指令缺少 " + path + ".col 或取值不在 0~7"};
+    }
+    return std::nullopt;
+}
+
+// 按请求结构的字段表解码请求体，成功返回空
+template <typename R>
+std::optional<DecodeError> decodeRequest(const std::string& body, R& out) {
+    if (auto err = RequestDecoder(fieldsOf(out)).decode(body)) return err;
+    return validate(out);
+}
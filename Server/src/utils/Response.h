@@ -1,24 +1,42 @@
 #pragma once
 #include "json.hpp"
+#include "JsonWriter.h"
+#include "Arena.h"
+#include <string>
 
 using json = nlohmann::json;
 
 // 统一响应辅助类
 class Response {
 public:
-    static json success(const json& data = nullptr) {
-        json res;
+    static ArenaJson success(const ArenaJson& data = nullptr) {
+        ArenaJson res;
         res["code"] = 200;
         if (data != nullptr) res["data"] = data;
         return res;
     }
 
-    static json error(int code, const std::string& msg) {
-        json res;
+    // 流式版本的 success：先写外层 {"code":200,"data": ，data 写完后调用 endSuccess
+    static void beginSuccess(JsonWriter& out) {
+        out.beginObject().key("code").value(200).key("data");
+    }
+    static void endSuccess(JsonWriter& out) {
+        out.endObject();
+    }
+
+    static ArenaJson error(int code, const std::string& msg) {
+        ArenaJson res;
         res["code"] = code;
         res["msg"] = msg;
         return res;
     }
+
+    // 请求参数错误，field 指出是哪个字段（请求体本身不合法时为空）
+    static std::string badRequest(const std::string& field, const std::string& msg) {
+        ArenaJson res = error(400, "参数错误: " + msg);
+        if (!field.empty()) res["field"] = field;
+        return res.dump();
+    }
 };//
 // Created by 敖翔 on 2025/12/24.
 //
\ No newline at end of file
@@ -0,0 +1,453 @@
+#include "WebPage.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <filesystem> // C++17 标准库，用于处理路径
+#include <unordered_map>
+#include <mutex>
+#include <ctime>
+#include <cstdio>
+#include <algorithm>
+#include <sys/stat.h>
+
+#ifdef GAME_HAS_ZLIB
+#include <zlib.h>
+#endif
+#ifdef GAME_HAS_BROTLI
+#include <brotli/encode.h>
+#endif
+#ifdef GAME_EMBED_STATIC
+#include "EmbeddedAssets.h" // 构建时由 cmake/EmbedAssets.cmake 生成
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#endif
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// FNV-1a 64 位内容哈希，用作强 ETag
+std::string contentHash(const std::string& data) {
+    unsigned long long h = 1469598103934665603ULL;
+    for (unsigned char ch : data) {
+        h ^= ch;
+        h *= 1099511628211ULL;
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "\"%016llx-%zx\"", h, data.size());
+    return buf;
+}
+
+// 大文件分块计算哈希，不需要整个读进内存
+std::string fileHash(const std::string& path, size_t size) {
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    unsigned long long h = 1469598103934665603ULL;
+    char buf[16384];
+    while (in.read(buf, sizeof(buf)) || in.gcount() > 0) {
+        for (std::streamsize i = 0; i < in.gcount(); ++i) {
+            h ^= static_cast<unsigned char>(buf[i]);
+            h *= 1099511628211ULL;
+        }
+    }
+    char out[32];
+    std::snprintf(out, sizeof(out), "\"%016llx-%zx\"", h, size);
+    return out;
+}
+
+// 转成 HTTP 日期，如 "Wed, 24 Dec 2025 08:00:00 GMT"
+std::string httpDate(long long t) {
+    std::time_t tt = static_cast<std::time_t>(t);
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &tt);
+#else
+    gmtime_r(&tt, &tm);
+#endif
+    char buf[64];
+    std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return buf;
+}
+
+long long fileMtime(const std::string& path) {
+    struct stat st {};
+    if (stat(path.c_str(), &st) != 0) return -1;
+    return static_cast<long long>(st.st_mtime);
+}
+
+// 只压缩文本类资源，图片/音频本身已经压缩过
+bool isCompressible(const std::string& mime) {
+    return mime.rfind("text/", 0) == 0 || mime == "application/javascript" ||
+           mime == "application/json" || mime == "image/svg+xml";
+}
+
+std::string gzipCompress(const std::string& data) {
+#ifdef GAME_HAS_ZLIB
+    z_stream zs{};
+    // windowBits 15 + 16 = 输出 gzip 头
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) return "";
+    std::string out(deflateBound(&zs, data.size()) + 32, '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    int ret = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return ret == Z_STREAM_END ? out : "";
+#else
+    (void)data;
+    return "";
+#endif
+}
+
+std::string brotliCompress(const std::string& data) {
+#ifdef GAME_HAS_BROTLI
+    size_t size = BrotliEncoderMaxCompressedSize(data.size());
+    if (size == 0) return "";
+    std::string out(size, '\0');
+    if (!BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                               data.size(), reinterpret_cast<const uint8_t*>(data.data()),
+                               &size, reinterpret_cast<uint8_t*>(&out[0]))) return "";
+    out.resize(size);
+    return out;
+#else
+    (void)data;
+    return "";
+#endif
+}
+
+} // namespace
+
+// 单例实现
+WebPage& WebPage::getInstance() {
+    static WebPage instance;
+    return instance;
+}
+
+WebPage::~WebPage() {
+    stop();
+}
+
+void WebPage::load(const std::string& dir) {
+#ifdef GAME_EMBED_STATIC
+    (void)dir;
+    loadEmbedded();
+    return;
+#endif
+    root = dir;
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    if (!fs::is_directory(dir, ec)) {
+        std::cerr << "Warning: static directory not found: " << dir << std::endl;
+        return;
+    }
+
+    size_t count = indexTree("");
+    std::cout << "[Info] Loaded " << count << " static assets from " << dir << std::endl;
+
+#ifdef __linux__
+    if (!watching.exchange(true)) watcher = std::thread(&WebPage::watch, this);
+#endif
+}
+
+size_t WebPage::indexTree(const std::string& dir) {
+    namespace fs = std::filesystem;
+    std::string top = dir.empty() ? root : root + "/" + dir;
+
+    size_t count = 0;
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(top, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file()) continue;
+        std::string name = fs::relative(it->path(), root, ec).generic_string();
+        if (name.empty() || name[0] == '.') continue; // 跳过 .DS_Store 之类的隐藏文件
+        reload(name);
+        count++;
+    }
+    return count;
+}
+
+void WebPage::dropTree(const std::string& dir) {
+    std::string prefix = dir + "/";
+    std::unique_lock<std::shared_mutex> l(asset_mutex);
+    auto it = assets.lower_bound(prefix);
+    while (it != assets.end() && it->first.compare(0, prefix.size(), prefix) == 0) it = assets.erase(it);
+}
+
+void WebPage::stop() {
+    watching = false;
+    if (watcher.joinable()) watcher.join();
+}
+
+std::shared_ptr<const StaticAsset> WebPage::find(const std::string& name) {
+    if (!isSafeName(name)) return nullptr;
+
+    std::shared_ptr<const StaticAsset> asset;
+    {
+        std::shared_lock<std::shared_mutex> l(asset_mutex);
+        auto it = assets.find(name);
+        if (it != assets.end()) asset = it->second;
+    }
+
+#ifndef __linux__
+    // 没有 inotify 的平台：按修改时间判断是否需要重新加载（一次 stat，远比整个读文件便宜）
+    if (asset && !embedded && fileMtime(root + "/" + name) != asset->mtime) {
+        reload(name);
+        std::shared_lock<std::shared_mutex> l(asset_mutex);
+        auto it = assets.find(name);
+        asset = (it != assets.end()) ? it->second : nullptr;
+    }
+#endif
+    return asset;
+}
+
+bool WebPage::isSafeName(const std::string& name) {
+    if (name.empty() || name[0] == '/' || name.find('\\') != std::string::npos) return false;
+    if (name.find('\0') != std::string::npos) return false;
+
+    // 逐段检查，任何一段是 ".." 都拒绝
+    size_t start = 0;
+    while (start <= name.size()) {
+        size_t end = name.find('/', start);
+        if (end == std::string::npos) end = name.size();
+        if (name.compare(start, end - start, "..") == 0 && end - start == 2) return false;
+        start = end + 1;
+    }
+    return true;
+}
+
+std::string WebPage::getMimeType(const std::string& filename) {
+    static const std::unordered_map<std::string, std::string> types = {
+        {"html", "text/html; charset=utf-8"},
+        {"htm", "text/html; charset=utf-8"},
+        {"css", "text/css"},
+        {"js", "application/javascript"},
+        {"json", "application/json"},
+        {"png", "image/png"},
+        {"jpg", "image/jpeg"},
+        {"jpeg", "image/jpeg"},
+        {"gif", "image/gif"},
+        {"svg", "image/svg+xml"},
+        {"ico", "image/x-icon"},
+        {"mp3", "audio/mpeg"},
+        {"ogg", "audio/ogg"},
+        {"wav", "audio/wav"},
+    };
+    size_t dot = filename.rfind('.');
+    if (dot == std::string::npos) return "text/plain";
+    auto it = types.find(filename.substr(dot + 1));
+    return it != types.end() ? it->second : "text/plain";
+}
+
+bool WebPage::slice(const StaticAsset& asset, size_t offset, size_t len, std::string& out) {
+    out.clear();
+    if (offset >= asset.size) return true;
+    len = std::min(len, asset.size - offset);
+    if (asset.in_memory) {
+        out = asset.body.substr(offset, len);
+        return true;
+    }
+
+    // 大文件读进有上限的缓冲（调用方保证 len 不超过 RANGE_CHUNK）。不用 mmap：
+    // 文件被原地截断时访问映射会 SIGBUS。读完再核对一次大小和修改时间，内容变了就不能再配旧的 ETag
+    out.resize(len);
+    size_t got = 0;
+#ifndef _WIN32
+    int fd = open(asset.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    while (got < len) {
+        ssize_t n = pread(fd, &out[got], len - got, static_cast<off_t>(offset + got));
+        if (n <= 0) break;
+        got += static_cast<size_t>(n);
+    }
+    struct stat st {};
+    bool same = fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == asset.size &&
+                static_cast<long long>(st.st_mtime) == asset.mtime;
+    close(fd);
+#else
+    std::ifstream in(asset.path, std::ios::in | std::ios::binary);
+    in.seekg(static_cast<std::streamoff>(offset));
+    in.read(&out[0], static_cast<std::streamsize>(len));
+    got = static_cast<size_t>(in.gcount());
+    std::error_code ec;
+    bool same = std::filesystem::file_size(asset.path, ec) == asset.size && !ec && fileMtime(asset.path) == asset.mtime;
+#endif
+    if (got != len || !same) {
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const StaticAsset> WebPage::loadAsset(const std::string& name) {
+    std::string path = root + "/" + name;
+
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) return nullptr;
+
+    auto asset = std::make_shared<StaticAsset>();
+    asset->path = path;
+    asset->size = static_cast<size_t>(size);
+    asset->mime = getMimeType(name);
+    asset->mtime = fileMtime(path);
+    asset->last_modified = httpDate(asset->mtime);
+
+    // 大文件（音频等）不进内存：整文件请求交给 Crow 按 16 KB 分块读盘发送，Range 请求按段读盘。
+    // 两条路径都经过用户态缓冲，不是零拷贝：Crow 不暴露连接的套接字，没法在上面调 sendfile
+    if (asset->size > STREAM_THRESHOLD) {
+        asset->in_memory = false;
+        asset->etag = fileHash(path, asset->size);
+        return asset;
+    }
+
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in) return nullptr;
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    asset->body = contents.str();
+    asset->size = asset->body.size();
+    asset->etag = contentHash(asset->body);
+
+    // 预压缩，只保留确实变小了的版本
+    if (isCompressible(asset->mime)) {
+        asset->gzip_body = gzipCompress(asset->body);
+        if (asset->gzip_body.size() >= asset->body.size()) asset->gzip_body.clear();
+        asset->br_body = brotliCompress(asset->body);
+        if (asset->br_body.size() >= asset->body.size()) asset->br_body.clear();
+    }
+    return asset;
+}
+
+void WebPage::loadEmbedded() {
+#ifdef GAME_EMBED_STATIC
+    embedded = true;
+    std::map<std::string, std::shared_ptr<const StaticAsset>> loaded;
+    for (size_t i = 0; i < EMBEDDED_ASSET_COUNT; i++) {
+        const EmbeddedAsset& e = EMBEDDED_ASSETS[i];
+        auto asset = std::make_shared<StaticAsset>();
+        // 内容、哈希、MIME 都是构建期算好的；没有磁盘文件可流式发送，所以大文件也放在内存里
+        asset->size = e.size;
+        asset->body.assign(reinterpret_cast<const char*>(e.data), e.size);
+        asset->etag = e.etag;
+        asset->mime = e.mime;
+        asset->last_modified = EMBEDDED_BUILD_TIME;
+        if (e.gzip_data) asset->gzip_body.assign(reinterpret_cast<const char*>(e.gzip_data), e.gzip_size);
+
+        // CMake 只能生成 gzip：brotli 版本 (以及老版本 CMake 下的 gzip) 启动时补一次
+        if (isCompressible(asset->mime)) {
+            if (!e.gzip_data) {
+                asset->gzip_body = gzipCompress(asset->body);
+                if (asset->gzip_body.size() >= asset->body.size()) asset->gzip_body.clear();
+            }
+            asset->br_body = brotliCompress(asset->body);
+            if (asset->br_body.size() >= asset->body.size()) asset->br_body.clear();
+        }
+        loaded[e.name] = asset;
+    }
+
+    std::unique_lock<std::shared_mutex> l(asset_mutex);
+    assets.swap(loaded);
+    std::cout << "[Info] Loaded " << assets.size() << " embedded static assets" << std::endl;
+#endif
+}
+
+void WebPage::reload(const std::string& name) {
+    auto asset = loadAsset(name);
+
+    std::unique_lock<std::shared_mutex> l(asset_mutex);
+    if (asset) assets[name] = asset;
+    else assets.erase(name); // 文件被删掉了
+}
+
+#ifdef __linux__
+void WebPage::watch() {
+    namespace fs = std::filesystem;
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return;
+
+    // inotify 不递归：索引到的每个目录各加一个 watch，子目录里的改动只报给子目录自己的 watch
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE;
+    std::unordered_map<int, std::string> dirs; // watch 描述符 -> 目录相对 root 的路径（根目录为 ""）
+    auto addTree = [&](const std::string& dir) {
+        std::string top = dir.empty() ? root : root + "/" + dir;
+        int wd = inotify_add_watch(fd, top.c_str(), mask);
+        if (wd < 0) return false;
+        dirs[wd] = dir;
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(top, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (!it->is_directory()) continue;
+            std::string rel = fs::relative(it->path(), root, ec).generic_string();
+            if (rel.empty() || rel[0] == '.') {
+                it.disable_recursion_pending(); // 和 indexTree 一致，隐藏目录不索引也不监听
+                continue;
+            }
+            int sub = inotify_add_watch(fd, it->path().c_str(), mask);
+            if (sub >= 0) dirs[sub] = rel;
+        }
+        return true;
+    };
+    // 目录被移走：撤掉它和子目录的 watch（移到 root 下别处时 IN_MOVED_TO 会重新加上）
+    auto removeTree = [&](const std::string& dir) {
+        std::string prefix = dir + "/";
+        for (auto it = dirs.begin(); it != dirs.end();) {
+            if (it->second == dir || it->second.compare(0, prefix.size(), prefix) == 0) {
+                inotify_rm_watch(fd, it->first);
+                it = dirs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    };
+
+    if (!addTree("")) {
+        close(fd);
+        return;
+    }
+
+    alignas(struct inotify_event) char buf[4096];
+    while (watching) {
+        // 带超时等待，保证 stop() 能及时退出
+        pollfd p{fd, POLLIN, 0};
+        if (poll(&p, 1, 500) <= 0) continue;
+
+        ssize_t n = read(fd, buf, sizeof(buf));
+        for (char* ptr = buf; n > 0 && ptr < buf + n; ) {
+            auto* ev = reinterpret_cast<struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + ev->len;
+
+            auto d = dirs.find(ev->wd);
+            if (ev->mask & IN_IGNORED) {
+                if (d != dirs.end()) dirs.erase(d); // 目录已删除，watch 被内核撤掉
+                continue;
+            }
+            if (d == dirs.end() || ev->len == 0 || ev->name[0] == '.') continue;
+            std::string name = d->second.empty() ? ev->name : d->second + "/" + ev->name;
+
+            if (ev->mask & IN_ISDIR) {
+                // 新建或移入的目录：监听并索引其中已有的文件；删掉或移走的目录：整棵子树下线
+                if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    std::cout << "[Info] Static directory added: " << name << std::endl;
+                    addTree(name);
+                    indexTree(name);
+                } else if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    std::cout << "[Info] Static directory removed: " << name << std::endl;
+                    if (ev->mask & IN_MOVED_FROM) removeTree(name);
+                    dropTree(name);
+                }
+            } else if (!(ev->mask & IN_CREATE)) { // 新建的文件等写完 (IN_CLOSE_WRITE) 再加载
+                std::cout << "[Info] Static asset changed: " << name << std::endl;
+                reload(name);
+            }
+        }
+    }
+    close(fd);
+}
+#else
+void WebPage::watch() {}
+#endif
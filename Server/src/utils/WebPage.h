@@ -1,34 +1,74 @@
 #pragma once
 #include <string>
-#include <fstream>
-#include <sstream>
-#include <iostream>
-#include <filesystem> // C++17 标准库，用于处理路径
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <thread>
+#include <atomic>
 
+// 一个静态资源：小文件整个放在内存里，大文件只保留元数据
+struct StaticAsset {
+    std::string path; // 磁盘路径（编译进二进制的资源为空）
+    size_t size = 0; // 文件大小（字节）
+    bool in_memory = true; // false 表示大文件，body 为空，走流式发送，Range 请求按段读盘
+    std::string body; // 原始内容（仅小文件）
+    std::string gzip_body; // gzip 预压缩版本（未启用 zlib 或压缩无收益时为空）
+    std::string br_body; // brotli 预压缩版本（未启用 brotli 或压缩无收益时为空）
+    std::string mime; // Content-Type
+    std::string etag; // 强 ETag（内容哈希，带引号）
+    std::string last_modified; // HTTP 日期格式的修改时间
+    long long mtime = 0; // 文件修改时间（秒）
+};
+
+// 静态资源仓库：启动时把 static 目录整体读进内存并建立索引，
+// 文件变化时（Linux 下 inotify，其他平台按修改时间）热更新对应条目。
+// 以 GAME_EMBED_STATIC 构建时资源已编译进二进制，不访问文件系统，也不监听变化
 class WebPage {
 public:
-    static std::string readFile(const std::string& filename) {
-        std::string path = "static/" + filename;
-
-        std::ifstream in(path, std::ios::in | std::ios::binary);
-        if (in) {
-            std::ostringstream contents;
-            contents << in.rdbuf();
-            in.close();
-            return contents.str();
-        } else {
-            std::cerr << "Warning: Could not open file: " << path << std::endl;
-            return "";
-        }
-    }
-
-    static std::string getMimeType(const std::string& filename) {
-        if (filename.find(".html") != std::string::npos) return "text/html";
-        if (filename.find(".png") != std::string::npos) return "image/png";
-        if (filename.find(".jpg") != std::string::npos || filename.find(".jpeg") != std::string::npos) return "image/jpeg";
-        if (filename.find(".css") != std::string::npos) return "text/css";
-        if (filename.find(".js") != std::string::npos) return "application/javascript";
-        if (filename.find(".mp3") != std::string::npos) return "audio/mpeg";
-        return "text/plain";
-    }
-};
\ No newline at end of file
+    // 单例获取
+    static WebPage& getInstance();
+
+    // 禁止拷贝
+    WebPage(const WebPage&) = delete;
+    void operator=(const WebPage&) = delete;
+
+    // 加载并索引目录下的所有文件，开始监听变化 (内嵌资源模式下忽略 dir)
+    void load(const std::string& dir = "static");
+    // 停止监听线程 (进程退出前调用)
+    void stop();
+
+    // 查找资源，不存在或文件名非法时返回空
+    std::shared_ptr<const StaticAsset> find(const std::string& name);
+
+    // 拒绝路径穿越：只允许相对路径，不允许 ".."、反斜杠和绝对路径
+    static bool isSafeName(const std::string& name);
+    static std::string getMimeType(const std::string& filename);
+
+    // 取出 [offset, offset + len) 这一段内容，大文件只读这一段。
+    // 磁盘上的文件已经被改写（大小或修改时间和 asset 不一致，热更新还没跟上）时返回 false
+    static bool slice(const StaticAsset& asset, size_t offset, size_t len, std::string& out);
+
+    inline static const size_t STREAM_THRESHOLD = 256 * 1024; // 超过此大小的文件不进内存，直接从磁盘发送
+    inline static const size_t RANGE_CHUNK = 1024 * 1024; // Range 请求单次最多返回的字节数
+
+private:
+    WebPage() = default; // 私有构造
+    ~WebPage();
+
+    std::string root;
+    bool embedded = false; // 资源来自二进制内嵌数据
+    std::map<std::string, std::shared_ptr<const StaticAsset>> assets; // 相对路径 -> 资源
+    std::shared_mutex asset_mutex;
+
+    std::thread watcher;
+    std::atomic<bool> watching{false};
+
+    std::shared_ptr<const StaticAsset> loadAsset(const std::string& name);
+    void loadEmbedded();
+    void reload(const std::string& name);
+    // 加载 root 下 dir 目录（相对路径，"" 为根）里的所有文件，返回文件数
+    size_t indexTree(const std::string& dir);
+    // 下线 dir 目录下的所有资源（目录被删除或移走）
+    void dropTree(const std::string& dir);
+    void watch();
+};